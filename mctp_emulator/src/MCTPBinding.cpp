@@ -74,6 +74,21 @@ static void sendMessageReceivedSignal(uint8_t msgType, uint8_t srcEid,
                                      mctpIntf.c_str(), "MessageReceivedSignal");
     msgSignal.append(msgType, srcEid, msgTag, tagOwner, response);
     msgSignal.signal_send();
+
+    std::string vendorId;
+    if (msgType == MCTP_MESSAGE_TYPE_VDPCI && response.size() >= 3)
+    {
+        char vendorIdStr[5];
+        snprintf(vendorIdStr, sizeof(vendorIdStr), "%02x%02x", response[1],
+                 response[2]);
+        vendorId = vendorIdStr;
+    }
+    auto filteredSignal =
+        bus->new_signal("/xyz/openbmc_project/mctp", mctpIntf.c_str(),
+                        "FilteredMessageReceivedSignal");
+    filteredSignal.append(std::to_string(msgType), vendorId, msgType, srcEid,
+                          msgTag, tagOwner, response);
+    filteredSignal.signal_send();
     phosphor::logging::log<phosphor::logging::level::INFO>(
         "Response signal sent");
 }
@@ -466,6 +481,41 @@ std::optional<std::pair<int, std::vector<uint8_t>>>
     }
 }
 
+static std::vector<uint8_t>
+    sendReceivePayload(boost::asio::yield_context yield, uint8_t dstEid,
+                       std::vector<uint8_t> payload, uint16_t timeout)
+{
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "mctp-emulator: Received Payload");
+
+    auto responsePair = processMctpCommand(dstEid, payload);
+
+    if (responsePair.has_value())
+    {
+        int processingDelay = std::get<0>(*responsePair);
+        std::vector<uint8_t> response = std::get<1>(*responsePair);
+
+        if (handleAtomicResponseTimeout(yield, processingDelay, timeout))
+        {
+            return response;
+        }
+        else
+        {
+            phosphor::logging::log<phosphor::logging::level::INFO>(
+                "mctp-emulator: Unable to respond within timeout");
+            throw sdbusplus::xyz::openbmc_project::Common::Error::Timeout();
+        }
+    }
+
+    else
+    {
+        createAsyncDelay(yield, timeout);
+        phosphor::logging::log<phosphor::logging::level::INFO>(
+            "mctp-emulator: Error in request");
+        throw sdbusplus::xyz::openbmc_project::Common::Error::Timeout();
+    }
+}
+
 MctpBinding::MctpBinding(
     std::shared_ptr<sdbusplus::asio::object_server>& objServer,
     std::string& objPath)
@@ -509,47 +559,22 @@ MctpBinding::MctpBinding(
             return rc;
         });
 
-    mctpInterface->register_method(
-        "SendReceiveMctpMessagePayload",
-        [](boost::asio::yield_context yield, uint8_t dstEid,
-           std::vector<uint8_t> payload, uint16_t timeout) {
-            phosphor::logging::log<phosphor::logging::level::INFO>(
-                "mctp-emulator: Received Payload");
-
-            auto responsePair = processMctpCommand(dstEid, payload);
+    mctpInterface->register_method("SendReceiveMctpMessagePayload",
+                                   sendReceivePayload);
 
-            if (responsePair.has_value())
-            {
-                int processingDelay = std::get<0>(*responsePair);
-                std::vector<uint8_t> response = std::get<1>(*responsePair);
-
-                if (handleAtomicResponseTimeout(yield, processingDelay,
-                                                timeout))
-                {
-                    return response;
-                }
-                else
-                {
-                    phosphor::logging::log<phosphor::logging::level::INFO>(
-                        "mctp-emulator: Unable to respond within timeout");
-                    throw sdbusplus::xyz::openbmc_project::Common::Error::
-                        Timeout();
-                }
-            }
-
-            else
-            {
-                createAsyncDelay(yield, timeout);
-                phosphor::logging::log<phosphor::logging::level::INFO>(
-                    "mctp-emulator: Error in request");
-                throw sdbusplus::xyz::openbmc_project::Common::Error::Timeout();
-            }
-        });
+    // Emulated endpoints answer every request, identical requests need no
+    // coalescing
+    mctpInterface->register_method("SendReceiveIdempotentMctpMessagePayload",
+                                   sendReceivePayload);
 
     mctpInterface->register_signal<uint8_t, uint8_t, uint8_t, bool,
                                    std::vector<uint8_t>>(
         "MessageReceivedSignal");
 
+    mctpInterface->register_signal<std::string, std::string, uint8_t, uint8_t,
+                                   uint8_t, bool, std::vector<uint8_t>>(
+        "FilteredMessageReceivedSignal");
+
     mctpInterface->register_property("Eid", eid);
 
     // TODO:Use the enum from D-Bus interface
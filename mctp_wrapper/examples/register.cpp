@@ -27,6 +27,7 @@
 #include "mctpw.h"
 #define UNUSED(x) (void)(x)
 #define EID_LIST_SIZE 32
+#define BUS_LIST_SIZE 16
 
 void* context;
 volatile bool run_flag = true;
@@ -60,14 +61,14 @@ int main(void)
     signal(SIGINT, signal_handler);
 
     /* find first MCTP_OVER_SMBUS binding */
-    for (bus = 0; bus < 10; bus++)
+    mctpw_bus_info_t buses[BUS_LIST_SIZE];
+    unsigned bus_list_size = BUS_LIST_SIZE;
+    if (mctpw_enumerate_buses(MCTP_OVER_SMBUS, buses, &bus_list_size) >= 0 &&
+        bus_list_size > 0)
     {
-        if (mctpw_find_bus_by_binding_type(MCTP_OVER_SMBUS, bus,
-                                           &bus_handler) == 0)
-        {
-            found = true;
-            break;
-        }
+        bus = static_cast<int>(buses[0].bus);
+        bus_handler = buses[0].mctpw_bus_handle;
+        found = true;
     }
     if (!found)
     {
@@ -19,19 +19,36 @@
 #include <endian.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include <algorithm>
 #include <atomic>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/container/flat_map.hpp>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message.hpp>
 #include <sdbusplus/slot.hpp>
+#include <set>
+#include <thread>
 
 #define UNUSED(x) (void)(x)
 
@@ -43,6 +60,7 @@ using MctpPropertiesVariantType =
                  uint8_t, std::vector<uint8_t>>;
 
 static std::shared_ptr<sdbusplus::bus::bus> mctpwBus;
+static std::mutex mctpwBusMutex;
 
 class mctpw_exception : public std::exception
 {
@@ -75,6 +93,54 @@ static const std::unordered_map<mctpw_binding_type_t, const std::string>
         {MCTP_OVER_SERIAL, ""},
         {VENDOR_DEFINED, ""}};
 
+/* Endpoint as seen in the mctpd object tree. Entries are created by any of
+ * the endpoint interfaces but only reported once the Endpoint interface is
+ * present, same as the ObjectMapper GetSubTree lookup used to do. */
+struct EndpointEntry
+{
+    bool isEndpoint = false;
+    mctpw_endpoint_properties_t properties{};
+};
+
+struct EndpointDirectory
+{
+    /* set once filled from GetManagedObjects, cleared on signal errors */
+    bool valid = false;
+    std::map<mctpw_eid_t, EndpointEntry> endpoints;
+};
+
+struct serviceContext;
+
+/* Per endpoint state of windowed request API */
+struct endpointRequests
+{
+    std::deque<mctpw_request_t> pending;
+    unsigned inFlight = 0;
+};
+
+struct requestQueue
+{
+    unsigned window = 1;
+    /* submitted and not yet completed */
+    unsigned outstanding = 0;
+    std::unordered_map<mctpw_eid_t, endpointRequests> endpoints;
+    std::deque<mctpw_completion_t> completions;
+};
+
+/* Network changes collected during quiet period, delivered to nc_cb and
+ * delta callback at once, @see mctpw_set_reconfiguration_callback() */
+struct reconfigurationNotice
+{
+    mctpw_reconfiguration_delta_callback_t cb = nullptr;
+    std::chrono::milliseconds quietPeriod{0};
+    bool pending = false;
+    std::set<mctpw_eid_t> added;
+    std::set<mctpw_eid_t> removed;
+    std::chrono::steady_clock::time_point firstChange;
+    std::chrono::steady_clock::time_point deadline;
+    std::unique_ptr<boost::asio::steady_timer> timer;
+};
+
 struct clientContext
 {
     ServiceHandleType* service_h;
@@ -88,9 +154,98 @@ struct clientContext
     mctpw_receive_message_callback_t rx_cb;
     std::shared_ptr<boost::asio::io_context> io_context;
     std::shared_ptr<sdbusplus::asio::connection> connection;
+    /* set by mctpw_unregister_client() to let mctpw_process() return */
+    std::atomic<bool> stopping{false};
+    serviceContext* service;
+    requestQueue requests;
+    reconfigurationNotice notice;
+};
+
+/* Received messages match, shared by clients with the same filter */
+struct receiveMatch
+{
+    unsigned clients = 0;
+    std::unique_ptr<sdbusplus::bus::match::match> match;
+};
+
+/* State shared by all clients registered on the same mctp service. Signal
+ * matches are installed once per service and demultiplexed to clients. */
+struct serviceContext
+{
+    std::string name;
+    EndpointDirectory directory;
+    /* clients keyed by message type they are registered for */
+    std::multimap<uint8_t, std::shared_ptr<clientContext>> clients;
     std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matchers;
+    /* keyed by arg0 (message type) and arg1 (VDPCI vendor id) filters */
+    std::map<std::pair<std::string, std::string>, receiveMatch>
+        receiveMatchers;
+};
+
+/* All clients in the process share one connection and one event loop */
+struct clientManager
+{
+    std::shared_ptr<boost::asio::io_context> io_context;
+    std::shared_ptr<sdbusplus::asio::connection> connection;
+    std::map<std::string, std::unique_ptr<serviceContext>> services;
+    std::unordered_map<void*, std::shared_ptr<clientContext>> clients;
+    /* set when any client dispatches signals keeping directories up to date */
+    bool tracked = false;
+    /* handlers were posted to io_context, they don't make connection fd
+     * ready so external event loop is told to dispatch immediately */
+    std::atomic<bool> pendingHandlers{false};
+    /* guards clients, services and their state, in threaded mode these are
+     * accessed from loop thread, workers and API callers. Never held while
+     * handlers or client callbacks run, they take it themselves. */
+    std::mutex mutex;
+    /* signalled when windowed request completes or client is unregistered,
+     * used in threaded mode */
+    std::condition_variable completionsCond;
+    /* threaded mode, loop runs in loopThread and client callbacks in workers,
+     * @see mctpw_start_worker_threads() */
+    bool threaded = false;
+    std::thread loopThread;
+    std::unique_ptr<boost::asio::thread_pool> workers;
+    std::optional<boost::asio::executor_work_guard<
+        boost::asio::io_context::executor_type>>
+        work;
 };
 
+static clientManager manager;
+
+static bool on_loop_thread()
+{
+    return std::this_thread::get_id() == manager.loopThread.get_id();
+}
+
+/* sd-bus is not thread-safe, in threaded mode everything touching the
+ * connection is executed from loop thread and the caller waits for result */
+template <typename F>
+static auto run_on_loop(F&& f) -> decltype(f())
+{
+    if (!manager.threaded || on_loop_thread())
+    {
+        return f();
+    }
+    std::packaged_task<decltype(f())()> task(std::forward<F>(f));
+    auto result = task.get_future();
+    boost::asio::post(*manager.io_context, [&task]() { task(); });
+    return result.get();
+}
+
+/* In threaded mode client callbacks are invoked from worker pool, so slow
+ * callback doesn't stall dispatching of other clients */
+template <typename F>
+static void run_callback(F&& f)
+{
+    if (manager.threaded)
+    {
+        boost::asio::post(*manager.workers, std::forward<F>(f));
+        return;
+    }
+    f();
+}
+
 template <typename Property>
 static auto
     read_property_value(sdbusplus::bus::bus& bus, const std::string& service,
@@ -129,10 +284,74 @@ static void call_method(sdbusplus::bus::bus& bus, const char* service,
     reply.read(response);
 }
 
+/* Makes method call created by build and returns what read gets from reply.
+ * In threaded mode call is sent asynchronously from loop thread and only the
+ * caller waits for reply, loop keeps dispatching other handlers meanwhile. */
+template <typename Build, typename Read>
+static auto call_blocking(Build&& build, Read&& read)
+    -> decltype(read(std::declval<sdbusplus::message::message&>()))
+{
+    using Result = decltype(read(std::declval<sdbusplus::message::message&>()));
+
+    if (!manager.threaded || on_loop_thread())
+    {
+        sdbusplus::bus::bus& bus =
+            static_cast<sdbusplus::bus::bus&>(*manager.connection);
+        auto msg = build(bus);
+        auto reply = bus.call(msg);
+        if (reply.is_method_error())
+        {
+            mctpw_exception err(reply.get_errno(), "Call method failed:");
+            throw err;
+        }
+        return read(reply);
+    }
+
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto result = promise->get_future();
+    boost::asio::post(*manager.io_context, [&build, &read, promise]() {
+        try
+        {
+            auto msg =
+                build(static_cast<sdbusplus::bus::bus&>(*manager.connection));
+            manager.connection->async_send(
+                msg, [&read, promise](boost::system::error_code ec,
+                                      sdbusplus::message::message& reply) {
+                    try
+                    {
+                        if (ec)
+                        {
+                            mctpw_exception err(ec.value(),
+                                                "Call method failed:");
+                            throw err;
+                        }
+                        if (reply.is_method_error())
+                        {
+                            mctpw_exception err(reply.get_errno(),
+                                                "Call method failed:");
+                            throw err;
+                        }
+                        promise->set_value(read(reply));
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return result.get();
+}
+
 static auto register_signal_handler(sdbusplus::bus::bus& bus,
                                     sd_bus_message_handler_t handler, void* ctx,
                                     std::string interface, std::string name,
-                                    std::string sender, std::string arg0)
+                                    std::string sender, std::string arg0,
+                                    std::string arg1 = "")
 {
     std::string matcherString = "type='signal',interface='";
 
@@ -144,98 +363,599 @@ static auto register_signal_handler(sdbusplus::bus::bus& bus,
     }
     if (arg0.size())
     {
-        matcherString += ", arg0=" + arg0;
+        matcherString += ", arg0='" + arg0 + "'";
+    }
+    if (arg1.size())
+    {
+        matcherString += ", arg1='" + arg1 + "'";
     }
 
     return std::make_unique<sdbusplus::bus::match::match>(bus, matcherString,
                                                           handler, ctx);
 }
 
-int mctpw_find_bus_by_binding_type(mctpw_binding_type_t binding_type,
-                                   unsigned bus_index, void** mctpw_bus_handle)
+static const std::string endpointInterface =
+    "xyz.openbmc_project.MCTP.Endpoint";
+static const std::string msgTypesInterface =
+    "xyz.openbmc_project.MCTP.SupportedMessageTypes";
+static const std::string uuidInterface = "xyz.openbmc_project.Common.UUID";
+
+static std::optional<mctpw_eid_t>
+    endpoint_eid_from_path(const std::string& path)
 {
-    try
+    static const std::string devicePath = "/xyz/openbmc_project/mctp/device/";
+
+    /* format of endpoint path: path/Eid */
+    if (path.compare(0, devicePath.size(), devicePath) != 0)
+    {
+        return std::nullopt;
+    }
+    const char* first = path.data() + devicePath.size();
+    const char* last = path.data() + path.size();
+    unsigned eid = 0;
+    auto result = std::from_chars(first, last, eid);
+    if (result.ec != std::errc() || result.ptr != last || first == last ||
+        eid > 0xFF)
     {
-        std::unique_ptr<ServiceHandleType> serviceHandle =
-            std::make_unique<ServiceHandleType>();
-        if (!mctpwBus)
+        return std::nullopt;
+    }
+    return static_cast<mctpw_eid_t>(eid);
+}
+
+static void parse_uuid(const std::string& str, uint8_t (&uuid)[16])
+{
+    /* format of UUID: xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx */
+    unsigned n = 0;
+    for (size_t i = 0; i + 1 < str.size() && n < sizeof(uuid);)
+    {
+        if (str[i] == '-')
+        {
+            i++;
+            continue;
+        }
+        uint8_t byte = 0;
+        auto result = std::from_chars(str.data() + i, str.data() + i + 2,
+                                      byte, 16);
+        if (result.ec != std::errc() || result.ptr != str.data() + i + 2)
         {
-            mctpwBus = std::make_shared<sdbusplus::bus::bus>(
-                sdbusplus::bus::new_default_system());
+            break;
         }
+        uuid[n++] = byte;
+        i += 2;
+    }
+}
 
-        DictType<std::string, std::vector<std::string>> services;
-        std::vector<std::string> interfaces;
-        interfaces.push_back(bindingToInterface.at(binding_type));
+static void update_endpoint_entry(
+    EndpointEntry& entry, const std::string& interface,
+    const DictType<std::string, MctpPropertiesVariantType>& properties)
+{
+    static const std::vector<
+        std::pair<const char*, bool mctpw_endpoint_properties_t::*>>
+        msgTypeProperties = {
+            {"MctpControl", &mctpw_endpoint_properties_t::mctp_control},
+            {"PLDM", &mctpw_endpoint_properties_t::pldm},
+            {"NCSI", &mctpw_endpoint_properties_t::ncsi},
+            {"Ethernet", &mctpw_endpoint_properties_t::ethernet},
+            {"NVMeMgmtMsg", &mctpw_endpoint_properties_t::nvme_mgmt_msg},
+            {"SPDM", &mctpw_endpoint_properties_t::spdm},
+            {"VDPCI", &mctpw_endpoint_properties_t::vdpci},
+            {"VDIANA", &mctpw_endpoint_properties_t::vdiana}};
+
+    if (interface == endpointInterface)
+    {
+        entry.isEndpoint = true;
+        auto it = properties.find("NetworkId");
+        if (it != properties.end())
+        {
+            entry.properties.network_id = std::get<uint16_t>(it->second);
+        }
+    }
+    else if (interface == msgTypesInterface)
+    {
+        for (auto& i : msgTypeProperties)
+        {
+            auto it = properties.find(i.first);
+            if (it != properties.end())
+            {
+                entry.properties.*(i.second) = std::get<bool>(it->second);
+            }
+        }
+    }
+    else if (interface == uuidInterface)
+    {
+        auto it = properties.find("UUID");
+        if (it != properties.end())
+        {
+            parse_uuid(std::get<std::string>(it->second),
+                       entry.properties.uuid);
+        }
+    }
+}
 
-        call_method(*(mctpwBus), "xyz.openbmc_project.ObjectMapper",
-                    "/xyz/openbmc_project/object_mapper",
-                    "xyz.openbmc_project.ObjectMapper", "GetObject", services,
-                    "/xyz/openbmc_project/mctp", interfaces);
+static bool supports_message_type(const mctpw_endpoint_properties_t& properties,
+                                  mctpw_message_type_t type)
+{
+    switch (type)
+    {
+        case PLDM:
+            return properties.pldm;
+        case NCSI:
+            return properties.ncsi;
+        case ETHERNET:
+            return properties.ethernet;
+        case NVME_MGMT_MSG:
+            return properties.nvme_mgmt_msg;
+        case SPDM:
+            return properties.spdm;
+        case VDPCI:
+            return properties.vdpci;
+        case VDIANA:
+            return properties.vdiana;
+    }
+    return false;
+}
 
-        for (auto& i : services)
+/* Directory is filled with one GetManagedObjects call and afterwards kept up
+ * to date by network_reconfiguration_cb. Until the client dispatches signals
+ * with mctpw_process() or mctpw_process_one() nothing would update it, so it
+ * is refreshed on every query. */
+static void refresh_endpoint_directory(clientContext* ctx)
+{
+    serviceContext* service = ctx->service;
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        if (service->directory.valid && manager.tracked)
         {
-            int bus = -1;
-            if (binding_type == MCTP_OVER_SMBUS)
+            return;
+        }
+    }
+
+    call_blocking(
+        [service](sdbusplus::bus::bus& bus) {
+            return bus.new_method_call(service->name.c_str(),
+                                       "/xyz/openbmc_project/mctp",
+                                       "org.freedesktop.DBus.ObjectManager",
+                                       "GetManagedObjects");
+        },
+        [service](sdbusplus::message::message& reply) {
+            DictType<sdbusplus::message::object_path,
+                     DictType<std::string,
+                              DictType<std::string, MctpPropertiesVariantType>>>
+                values;
+            reply.read(values);
+
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            EndpointDirectory& directory = service->directory;
+            directory.endpoints.clear();
+            for (auto& path : values)
             {
-                std::string pv = read_property_value<std::string>(
-                    *mctpwBus, i.first, "/xyz/openbmc_project/mctp",
-                    bindingToInterface.at(binding_type), "BusPath");
-                /* format of BusPath:path-bus */
-                std::vector<std::string> splitted;
-                boost::split(splitted, pv, boost::is_any_of("-"));
-                if (splitted.size() == 2)
+                auto eid = endpoint_eid_from_path(path.first);
+                if (!eid)
                 {
-                    try
-                    {
-                        bus = std::stoi(splitted[1]);
-                    }
-                    catch (std::exception& e)
-                    {
-                        phosphor::logging::log<phosphor::logging::level::ERR>(
-                            e.what());
-                        continue;
-                    }
+                    continue;
+                }
+                EndpointEntry& entry = directory.endpoints[*eid];
+                for (auto& interface : path.second)
+                {
+                    update_endpoint_entry(entry, interface.first,
+                                          interface.second);
                 }
             }
-            else if (binding_type == MCTP_OVER_PCIE_VDM)
-            {
-                uint16_t pv = read_property_value<uint16_t>(
-                    *mctpwBus, i.first, "/xyz/openbmc_project/mctp",
-                    bindingToInterface.at(binding_type), "BDF");
-                /* format of BDF:
-                 *  Byte 1 [7:0] Bus number
-                 *  Byte 2 [7:3] Device number [2:0] Function Number
-                 */
-                bus = pv & 0xff;
-            }
-            else
-            {
-                mctpw_exception err(EINVAL, "Unsupported binding type:");
-                throw err;
-            }
+            directory.valid = true;
+            return true;
+        });
+}
 
-            if (static_cast<unsigned>(bus) == bus_index)
+/* Bus number read from binding interface property of one mctp service */
+struct busNumberRequest
+{
+    mctpw_binding_type_t bindingType;
+    std::string service;
+    std::optional<unsigned> bus;
+    bool done = false;
+    /* set once the call is sent */
+    std::optional<sdbusplus::slot::slot> slot;
+};
+
+static std::optional<unsigned> parse_bus_number(mctpw_binding_type_t binding,
+                                                sdbusplus::message::message& m)
+{
+    if (binding == MCTP_OVER_SMBUS)
+    {
+        std::variant<std::string> pv;
+        m.read(pv);
+        /* format of BusPath:path-bus */
+        std::vector<std::string> splitted;
+        boost::split(splitted, std::get<std::string>(pv),
+                     boost::is_any_of("-"));
+        unsigned bus = 0;
+        if (splitted.size() != 2 ||
+            std::from_chars(splitted[1].data(),
+                            splitted[1].data() + splitted[1].size(), bus)
+                    .ec != std::errc())
+        {
+            return std::nullopt;
+        }
+        return bus;
+    }
+    if (binding == MCTP_OVER_PCIE_VDM)
+    {
+        std::variant<uint16_t> pv;
+        m.read(pv);
+        /* format of BDF:
+         *  Byte 1 [7:0] Bus number
+         *  Byte 2 [7:3] Device number [2:0] Function Number
+         */
+        return std::get<uint16_t>(pv) & 0xff;
+    }
+    return std::nullopt;
+}
+
+static int bus_number_cb(sd_bus_message* m, void* userdata,
+                         sd_bus_error* ret_error)
+{
+    busNumberRequest* request = static_cast<busNumberRequest*>(userdata);
+    request->done = true;
+    if (ret_error && sd_bus_error_is_set(ret_error))
+    {
+        return 0;
+    }
+    try
+    {
+        sdbusplus::message::message reply{m};
+        if (!reply.is_method_error())
+        {
+            request->bus = parse_bus_number(request->bindingType, reply);
+        }
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            e.what(),
+            phosphor::logging::entry("SERVICE=%s", request->service.c_str()));
+    }
+    return 0;
+}
+
+/* Buses of one binding type in order reported by ObjectMapper */
+struct busList
+{
+    bool valid = false;
+    std::vector<mctpw_bus_info_t> buses;
+};
+
+/* Enumerated buses, invalidated when an mctp service appears or leaves the
+ * bus. Handles are never freed since registered clients keep them. */
+struct busCache
+{
+    std::map<mctpw_binding_type_t, busList> lists;
+    std::map<std::string, std::unique_ptr<ServiceHandleType>> handles;
+    /* new names in xyz.openbmc_project namespace, one may provide a binding */
+    std::unique_ptr<sdbusplus::bus::match::match> nameAcquiredMatch;
+    /* owner changes of known mctp services, keyed by service name */
+    std::map<std::string, std::unique_ptr<sdbusplus::bus::match::match>>
+        serviceOwnerMatches;
+};
+
+static busCache buses;
+
+static int name_owner_changed_cb(sd_bus_message*, void*,
+                                 sd_bus_error* ret_error)
+{
+    if (ret_error && sd_bus_error_is_set(ret_error))
+    {
+        return 0;
+    }
+    /* broker delivers only changes cache depends on, @see watch_name_owner */
+    for (auto& list : buses.lists)
+    {
+        list.second.valid = false;
+    }
+    return 0;
+}
+
+static std::unique_ptr<sdbusplus::bus::match::match>
+    watch_name_owner(sdbusplus::bus::bus& bus, const std::string& args)
+{
+    return std::make_unique<sdbusplus::bus::match::match>(
+        bus,
+        "type='signal',sender='org.freedesktop.DBus',"
+        "interface='org.freedesktop.DBus',member='NameOwnerChanged'," +
+            args,
+        name_owner_changed_cb, nullptr);
+}
+
+/* Reads bus number of every service. All calls are sent before waiting for
+ * the first reply so enumeration takes two round trips in total. */
+static void read_bus_numbers(sdbusplus::bus::bus& bus,
+                             std::vector<busNumberRequest>& requests)
+{
+    for (auto& request : requests)
+    {
+        const std::string& interface = bindingToInterface.at(
+            request.bindingType);
+        auto msg = bus.new_method_call(
+            request.service.c_str(), "/xyz/openbmc_project/mctp",
+            "org.freedesktop.DBus.Properties", "Get");
+        msg.append(interface.c_str(), request.bindingType == MCTP_OVER_SMBUS
+                                          ? "BusPath"
+                                          : "BDF");
+        sd_bus_slot* slot = nullptr;
+        int rc = sd_bus_call_async(bus.get(), &slot, msg.get(), bus_number_cb,
+                                   &request, 0);
+        if (rc < 0)
+        {
+            throw mctpw_exception(-rc, "Bus number request failed:");
+        }
+        request.slot.emplace(slot);
+    }
+
+    auto pending = [&requests]() {
+        return std::any_of(
+            requests.begin(), requests.end(),
+            [](const busNumberRequest& r) { return !r.done; });
+    };
+    while (pending())
+    {
+        int rc = sd_bus_process(bus.get(), nullptr);
+        if (rc == 0)
+        {
+            rc = sd_bus_wait(bus.get(), UINT64_MAX);
+        }
+        if (rc < 0)
+        {
+            throw mctpw_exception(-rc, "Bus number read failed:");
+        }
+    }
+}
+
+static busList& get_bus_list(mctpw_binding_type_t binding_type)
+{
+    if (binding_type != MCTP_OVER_SMBUS && binding_type != MCTP_OVER_PCIE_VDM)
+    {
+        throw mctpw_exception(EINVAL, "Unsupported binding type:");
+    }
+
+    if (!mctpwBus)
+    {
+        mctpwBus = std::make_shared<sdbusplus::bus::bus>(
+            sdbusplus::bus::new_default_system());
+    }
+    if (!buses.nameAcquiredMatch)
+    {
+        /* empty old owner, name was not owned before */
+        buses.nameAcquiredMatch = watch_name_owner(
+            *mctpwBus, "arg0namespace='xyz.openbmc_project',arg1=''");
+    }
+    /* Plain bus has no event loop, dispatch queued NameOwnerChanged */
+    while (sd_bus_process(mctpwBus->get(), nullptr) > 0)
+    {
+    }
+
+    busList& list = buses.lists[binding_type];
+    if (list.valid)
+    {
+        return list;
+    }
+
+    DictType<std::string, std::vector<std::string>> services;
+    std::vector<std::string> interfaces;
+    interfaces.push_back(bindingToInterface.at(binding_type));
+
+    call_method(*(mctpwBus), "xyz.openbmc_project.ObjectMapper",
+                "/xyz/openbmc_project/object_mapper",
+                "xyz.openbmc_project.ObjectMapper", "GetObject", services,
+                "/xyz/openbmc_project/mctp", interfaces);
+
+    /* callbacks keep pointers to requests, vector must not reallocate */
+    std::vector<busNumberRequest> requests;
+    requests.reserve(services.size());
+    for (auto& i : services)
+    {
+        busNumberRequest& request = requests.emplace_back();
+        request.bindingType = binding_type;
+        request.service = i.first;
+    }
+    read_bus_numbers(*mctpwBus, requests);
+
+    list.buses.clear();
+    for (auto& i : requests)
+    {
+        if (!i.bus)
+        {
+            continue;
+        }
+        auto& handle = buses.handles[i.service];
+        if (!handle)
+        {
+            handle = std::make_unique<ServiceHandleType>(binding_type,
+                                                         i.service);
+            /* service restarted or left */
+            buses.serviceOwnerMatches.emplace(
+                i.service,
+                watch_name_owner(*mctpwBus, "arg0='" + i.service + "'"));
+        }
+        list.buses.push_back(mctpw_bus_info_t{handle.get(), *i.bus});
+    }
+    list.valid = true;
+    return list;
+}
+
+int mctpw_find_bus_by_binding_type(mctpw_binding_type_t binding_type,
+                                   unsigned bus_index, void** mctpw_bus_handle)
+{
+    /* mctpwBus is a plain blocking connection used only for bus lookup */
+    std::lock_guard<std::mutex> lock(mctpwBusMutex);
+
+    try
+    {
+        busList& list = get_bus_list(binding_type);
+        for (auto& bus : list.buses)
+        {
+            if (bus.bus == bus_index)
             {
-                serviceHandle->first = binding_type;
-                serviceHandle->second = i.first;
-                *mctpw_bus_handle = static_cast<void*>(serviceHandle.release());
+                *mctpw_bus_handle = bus.mctpw_bus_handle;
                 return 0;
             }
         }
     }
-    catch (std::exception& e)
+    catch (mctpw_exception& e)
+    {
+        *mctpw_bus_handle = nullptr;
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return e.get() == EINVAL ? -EINVAL : -EREMOTEIO;
+    }
+    catch (std::exception& e)
+    {
+        *mctpw_bus_handle = nullptr;
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EREMOTEIO;
+    }
+    catch (...)
+    {
+        *mctpw_bus_handle = nullptr;
+        return -EREMOTEIO;
+    }
+    return -ENOENT;
+}
+
+int mctpw_enumerate_buses(mctpw_binding_type_t binding_type,
+                          mctpw_bus_info_t* bus_list, unsigned* num)
+{
+    if (!bus_list || !num)
+    {
+        return -EINVAL;
+    }
+
+    std::lock_guard<std::mutex> lock(mctpwBusMutex);
+    try
+    {
+        busList& list = get_bus_list(binding_type);
+        unsigned count = static_cast<unsigned>(
+            std::min<size_t>(*num, list.buses.size()));
+        std::copy_n(list.buses.begin(), count, bus_list);
+        *num = count;
+        return static_cast<int>(list.buses.size() - count);
+    }
+    catch (mctpw_exception& e)
+    {
+        *num = 0;
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return e.get() == EINVAL ? -EINVAL : -EREMOTEIO;
+    }
+    catch (std::exception& e)
+    {
+        *num = 0;
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EREMOTEIO;
+    }
+    catch (...)
+    {
+        *num = 0;
+        return -EREMOTEIO;
+    }
+}
+
+/* Continuous changes postpone notification at most this many quiet periods */
+static constexpr unsigned maxQuietPeriods = 4;
+
+static void
+    deliver_reconfiguration(const std::shared_ptr<clientContext>& client)
+{
+    std::vector<mctpw_eid_t> added;
+    std::vector<mctpw_eid_t> removed;
+    mctpw_reconfiguration_callback_t ncCb;
+    mctpw_reconfiguration_delta_callback_t deltaCb;
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        reconfigurationNotice& notice = client->notice;
+        if (!notice.pending || client->stopping)
+        {
+            return;
+        }
+        notice.pending = false;
+        added.assign(notice.added.begin(), notice.added.end());
+        removed.assign(notice.removed.begin(), notice.removed.end());
+        notice.added.clear();
+        notice.removed.clear();
+        ncCb = client->nc_cb;
+        deltaCb = notice.cb;
+    }
+    run_callback([client, ncCb, deltaCb, added = std::move(added),
+                  removed = std::move(removed)]() {
+        if (ncCb)
+        {
+            ncCb(static_cast<void*>(client.get()));
+        }
+        if (deltaCb)
+        {
+            deltaCb(static_cast<void*>(client.get()), added.data(),
+                    static_cast<unsigned>(added.size()), removed.data(),
+                    static_cast<unsigned>(removed.size()));
+        }
+    });
+}
+
+/* Merges changes of one signal into notice of the client and (re)arms quiet
+ * period timer. Endpoint added and removed within one period is not
+ * reported at all, removed and added again is reported in both lists.
+ * Returns true when notice should be delivered right away. */
+static bool note_reconfiguration(const std::shared_ptr<clientContext>& client,
+                                 const std::vector<mctpw_eid_t>& added,
+                                 const std::vector<mctpw_eid_t>& removed)
+{
+    reconfigurationNotice& notice = client->notice;
+    for (auto eid : added)
+    {
+        notice.added.insert(eid);
+    }
+    for (auto eid : removed)
+    {
+        if (notice.added.erase(eid) == 0)
+        {
+            notice.removed.insert(eid);
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!notice.pending)
     {
-        *mctpw_bus_handle = nullptr;
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-        return -EREMOTEIO;
+        notice.pending = true;
+        notice.firstChange = now;
     }
-    catch (...)
+    if (notice.quietPeriod.count() == 0)
     {
-        *mctpw_bus_handle = nullptr;
-        return -EREMOTEIO;
+        return true;
     }
-    return -ENOENT;
+
+    notice.deadline =
+        std::min(now + notice.quietPeriod,
+                 notice.firstChange + notice.quietPeriod * maxQuietPeriods);
+    if (!notice.timer)
+    {
+        notice.timer =
+            std::make_unique<boost::asio::steady_timer>(*(client->io_context));
+    }
+    notice.timer->expires_at(notice.deadline);
+    /* weak reference, pending handler must not keep unregistered client */
+    notice.timer->async_wait([weak = std::weak_ptr<clientContext>(client)](
+                                 const boost::system::error_code& ec) {
+        auto c = weak.lock();
+        if (ec || !c)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            /* handler of replaced wait that already expired */
+            if (std::chrono::steady_clock::now() < c->notice.deadline)
+            {
+                return;
+            }
+        }
+        deliver_reconfiguration(c);
+    });
+    return false;
 }
 
 static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
@@ -255,15 +975,14 @@ static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
         return 0;
     }
 
+    serviceContext* service = static_cast<serviceContext*>(userdata);
     try
     {
-        clientContext* context = static_cast<clientContext*>(userdata);
+        std::unique_lock<std::mutex> lock(manager.mutex);
         sdbusplus::message::message message{m};
-
-        if (!context->nc_cb)
-        {
-            return 0;
-        }
+        bool notify = false;
+        std::vector<mctpw_eid_t> added;
+        std::vector<mctpw_eid_t> removed;
 
         std::string cb_type = message.get_member();
 
@@ -279,12 +998,23 @@ static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
 
             message.read(interface, properties);
 
+            auto eid = endpoint_eid_from_path(message.get_path());
+            if (eid)
+            {
+                auto entry = service->directory.endpoints.find(*eid);
+                if (entry != service->directory.endpoints.end())
+                {
+                    update_endpoint_entry(entry->second, interface,
+                                          properties);
+                }
+            }
+
             for (auto& i : properties)
             {
                 if (std::find(tracedProperties.begin(), tracedProperties.end(),
                               i.first) != tracedProperties.end())
                 {
-                    context->nc_cb(userdata);
+                    notify = true;
                 }
             }
         }
@@ -301,12 +1031,23 @@ static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
 
             message.read(object_path, values);
 
+            auto eid = endpoint_eid_from_path(object_path);
             for (auto& i : values)
             {
+                if (eid)
+                {
+                    EndpointEntry& entry = service->directory.endpoints[*eid];
+                    bool wasEndpoint = entry.isEndpoint;
+                    update_endpoint_entry(entry, i.first, i.second);
+                    if (!wasEndpoint && entry.isEndpoint)
+                    {
+                        added.push_back(*eid);
+                    }
+                }
                 if (std::find(tracedInterfaces.begin(), tracedInterfaces.end(),
                               i.first) != tracedInterfaces.end())
                 {
-                    context->nc_cb(userdata);
+                    notify = true;
                 }
             }
         }
@@ -319,12 +1060,19 @@ static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
             sdbusplus::message::object_path object_path;
 
             message.read(object_path, values);
+
+            auto eid = endpoint_eid_from_path(object_path);
             for (auto& i : values)
             {
+                if (eid && i == endpointInterface)
+                {
+                    service->directory.endpoints.erase(*eid);
+                    removed.push_back(*eid);
+                }
                 if (std::find(tracedInterfaces.begin(), tracedInterfaces.end(),
                               i) != tracedInterfaces.end())
                 {
-                    context->nc_cb(userdata);
+                    notify = true;
                 }
             }
         }
@@ -332,13 +1080,38 @@ static int network_reconfiguration_cb(sd_bus_message* m, void* userdata,
         {
             return 0;
         }
+
+        if (!notify)
+        {
+            return 0;
+        }
+        /* callback may unregister clients, iterate over a copy */
+        std::vector<std::shared_ptr<clientContext>> clients;
+        for (auto& i : service->clients)
+        {
+            if ((i.second->nc_cb || i.second->notice.cb) &&
+                note_reconfiguration(i.second, added, removed))
+            {
+                clients.push_back(i.second);
+            }
+        }
+        lock.unlock();
+        for (auto& client : clients)
+        {
+            deliver_reconfiguration(client);
+        }
     }
     catch (std::exception& e)
     {
+        /* signal could not be applied, fill directory again on next query */
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        service->directory.valid = false;
         phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
     }
     catch (...)
     {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        service->directory.valid = false;
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "Unknown exception from  network_reconfiguration_cb");
     }
@@ -356,44 +1129,86 @@ static int receive_cb(sd_bus_message* m, void* userdata,
 
     try
     {
-        clientContext* context = static_cast<clientContext*>(userdata);
+        serviceContext* service = static_cast<serviceContext*>(userdata);
         sdbusplus::message::message message{m};
 
-        if (!context->rx_cb)
-        {
-            return 0;
-        }
+        std::string messageTypeKey;
+        std::string vendorIdKey;
         uint8_t messageType;
         uint8_t srcEid;
         uint8_t msgTag;
         bool tagOwner;
-        std::vector<uint8_t> payload;
 
-        message.read(messageType, srcEid, msgTag, tagOwner, payload);
+        /* broker already filtered on message type and vendor id keys, only
+         * vendor message type mask is left to check here */
+        message.read(messageTypeKey, vendorIdKey, messageType, srcEid, msgTag,
+                     tagOwner);
 
-        if (messageType != context->type)
+        /* payload is passed to clients from message buffer, without copy */
+        const void* payloadData = nullptr;
+        size_t payloadSize = 0;
+        if (sd_bus_message_read_array(m, 'y', &payloadData, &payloadSize) < 0)
         {
             return 0;
         }
+        uint8_t* payload =
+            static_cast<uint8_t*>(const_cast<void*>(payloadData));
+
+        struct VendorHeader
+        {
+            uint16_t vendor_id;
+            uint16_t vendor_message_id;
+        }* vendorHdr = nullptr;
 
         if (messageType == VDPCI)
         {
-            struct VendorHeader
-            {
-                uint16_t vendor_id;
-                uint16_t vendor_message_id;
-            }* vendorHdr = reinterpret_cast<VendorHeader*>(payload.data());
-
-            if ((vendorHdr->vendor_id != context->vendor_id) ||
-                ((vendorHdr->vendor_message_id &
-                  context->vendor_message_type_mask) !=
-                 context->vendor_message_type))
+            if (payloadSize < sizeof(VendorHeader))
             {
                 return 0;
             }
+            vendorHdr = reinterpret_cast<VendorHeader*>(payload);
+        }
+
+        /* callback may unregister clients, iterate over a copy */
+        std::vector<std::shared_ptr<clientContext>> clients;
+        std::unique_lock<std::mutex> lock(manager.mutex);
+        auto range = service->clients.equal_range(messageType);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            clientContext* context = it->second.get();
+            if (!context->rx_cb)
+            {
+                continue;
+            }
+            if (vendorHdr &&
+                ((vendorHdr->vendor_id != context->vendor_id) ||
+                 ((vendorHdr->vendor_message_id &
+                   context->vendor_message_type_mask) !=
+                  context->vendor_message_type)))
+            {
+                continue;
+            }
+            clients.push_back(it->second);
+        }
+
+        lock.unlock();
+
+        for (auto& client : clients)
+        {
+            if (!manager.threaded)
+            {
+                client->rx_cb(static_cast<void*>(client.get()), srcEid,
+                              tagOwner, msgTag, payload, payloadSize, 0);
+                continue;
+            }
+            /* message buffer is released once this handler returns */
+            run_callback([client, srcEid, tagOwner, msgTag,
+                          data = std::vector<uint8_t>(
+                              payload, payload + payloadSize)]() mutable {
+                client->rx_cb(static_cast<void*>(client.get()), srcEid,
+                              tagOwner, msgTag, data.data(), data.size(), 0);
+            });
         }
-        context->rx_cb(context, srcEid, tagOwner, msgTag, payload.data(),
-                       payload.size(), 0);
     }
     catch (std::exception& e)
     {
@@ -408,6 +1223,94 @@ static int receive_cb(sd_bus_message* m, void* userdata,
     return 0;
 }
 
+static void create_connection()
+{
+    if (!manager.connection)
+    {
+        manager.io_context = std::make_shared<boost::asio::io_context>();
+        manager.connection = std::make_shared<sdbusplus::asio::connection>(
+            *(manager.io_context.get()));
+        manager.tracked = false;
+    }
+}
+
+static serviceContext* get_service_context(const std::string& name)
+{
+    create_connection();
+
+    auto it = manager.services.find(name);
+    if (it != manager.services.end())
+    {
+        return it->second.get();
+    }
+
+    auto service = std::make_unique<serviceContext>();
+    service->name = name;
+
+    /* endpoint directory is maintained from these signals also for clients
+     * not interested in network change notifications */
+    service->matchers.push_back(register_signal_handler(
+        static_cast<sdbusplus::bus::bus&>(*manager.connection),
+        network_reconfiguration_cb, static_cast<void*>(service.get()),
+        "org.freedesktop.DBus.Properties", "PropertiesChanged", name, ""));
+    service->matchers.push_back(register_signal_handler(
+        static_cast<sdbusplus::bus::bus&>(*manager.connection),
+        network_reconfiguration_cb, static_cast<void*>(service.get()),
+        "org.freedesktop.DBus.ObjectManager", "InterfacesAdded", name, ""));
+    service->matchers.push_back(register_signal_handler(
+        static_cast<sdbusplus::bus::bus&>(*manager.connection),
+        network_reconfiguration_cb, static_cast<void*>(service.get()),
+        "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved", name, ""));
+
+    return manager.services.emplace(name, std::move(service))
+        .first->second.get();
+}
+
+static std::pair<std::string, std::string>
+    receive_match_key(const clientContext& ctx)
+{
+    std::pair<std::string, std::string> key;
+
+    /* format of keys must follow FilteredMessageReceivedSignal of mctpd:
+     * message type as decimal, vendor id as 4 lower case hex digits */
+    key.first = std::to_string(static_cast<unsigned>(ctx.type));
+    if (ctx.type == VDPCI)
+    {
+        char vendorId[5];
+        snprintf(vendorId, sizeof(vendorId), "%04x", be16toh(ctx.vendor_id));
+        key.second = vendorId;
+    }
+    return key;
+}
+
+static void add_receive_match(serviceContext* service,
+                              const clientContext& ctx)
+{
+    auto key = receive_match_key(ctx);
+    receiveMatch& rxMatch = service->receiveMatchers[key];
+
+    if (!rxMatch.match)
+    {
+        rxMatch.match = register_signal_handler(
+            static_cast<sdbusplus::bus::bus&>(*manager.connection), receive_cb,
+            static_cast<void*>(service), "xyz.openbmc_project.MCTP.Base",
+            "FilteredMessageReceivedSignal", service->name, key.first,
+            key.second);
+    }
+    rxMatch.clients++;
+}
+
+static void remove_receive_match(serviceContext* service,
+                                 const clientContext& ctx)
+{
+    auto it = service->receiveMatchers.find(receive_match_key(ctx));
+
+    if (it != service->receiveMatchers.end() && --(it->second.clients) == 0)
+    {
+        service->receiveMatchers.erase(it);
+    }
+}
+
 int mctpw_register_client(void* mctpw_bus_handle, mctpw_message_type_t type,
                           uint16_t vendor_id, bool receive_requests,
                           uint16_t vendor_message_type,
@@ -416,85 +1319,87 @@ int mctpw_register_client(void* mctpw_bus_handle, mctpw_message_type_t type,
                           mctpw_receive_message_callback_t rx_cb,
                           void** client_context)
 {
-    clientContext* ctx = new clientContext;
     UNUSED(receive_requests);
 
     if (!mctpw_bus_handle)
     {
         return -EINVAL;
     }
-    if (!ctx)
-    {
-        return -ENOMEM;
-    }
 
-    try
-    {
-        ctx->io_context = std::make_shared<boost::asio::io_context>();
-        ctx->connection = std::make_shared<sdbusplus::asio::connection>(
-            *(ctx->io_context.get()));
-
-        ctx->service_h = static_cast<ServiceHandleType*>(mctpw_bus_handle);
-        ctx->type = type;
-        ctx->vendor_id = htobe16(vendor_id);
-        ctx->vendor_message_type = htobe16(vendor_message_type);
-        ctx->vendor_message_type_mask = htobe16(vendor_message_type_mask);
-        ctx->rx_cb = rx_cb ? rx_cb : nullptr;
-        ctx->nc_cb = nc_cb ? nc_cb : nullptr;
-
-        if (ctx->nc_cb)
-        {
-            ctx->matchers.push_back(register_signal_handler(
-                static_cast<sdbusplus::bus::bus&>(*ctx->connection),
-                network_reconfiguration_cb, static_cast<void*>(ctx),
-                "org.freedesktop.DBus.Properties", "PropertiesChanged",
-                ctx->service_h->second, ""));
-            ctx->matchers.push_back(register_signal_handler(
-                static_cast<sdbusplus::bus::bus&>(*ctx->connection),
-                network_reconfiguration_cb, static_cast<void*>(ctx),
-                "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
-                ctx->service_h->second, ""));
-            ctx->matchers.push_back(register_signal_handler(
-                static_cast<sdbusplus::bus::bus&>(*ctx->connection),
-                network_reconfiguration_cb, static_cast<void*>(ctx),
-                "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved",
-                ctx->service_h->second, ""));
+    /* matches are added from loop thread in threaded mode */
+    return run_on_loop([&]() {
+        try
+        {
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            auto ctx = std::make_shared<clientContext>();
+
+            ctx->service_h = static_cast<ServiceHandleType*>(mctpw_bus_handle);
+            ctx->type = type;
+            ctx->vendor_id = htobe16(vendor_id);
+            ctx->vendor_message_type = htobe16(vendor_message_type);
+            ctx->vendor_message_type_mask = htobe16(vendor_message_type_mask);
+            ctx->rx_cb = rx_cb ? rx_cb : nullptr;
+            ctx->nc_cb = nc_cb ? nc_cb : nullptr;
+
+            ctx->service = get_service_context(ctx->service_h->second);
+            ctx->io_context = manager.io_context;
+            ctx->connection = manager.connection;
+
+            if (ctx->rx_cb)
+            {
+                add_receive_match(ctx->service, *ctx);
+            }
+            ctx->service->clients.emplace(static_cast<uint8_t>(type), ctx);
+            manager.clients.emplace(static_cast<void*>(ctx.get()), ctx);
+            *client_context = static_cast<void*>(ctx.get());
         }
-        if (ctx->rx_cb)
+        catch (std::exception& e)
         {
-            ctx->matchers.push_back(register_signal_handler(
-                static_cast<sdbusplus::bus::bus&>(*ctx->connection), receive_cb,
-                static_cast<void*>(ctx), "xyz.openbmc_project.MCTP.Base",
-                "MessageReceivedSignal", ctx->service_h->second, ""));
+            phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+            *client_context = nullptr;
+            return -EINVAL;
         }
-    }
-    catch (std::exception& e)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-        delete ctx;
-        *client_context = nullptr;
-        return -EINVAL;
-    }
-    catch (...)
-    {
-        delete ctx;
-        *client_context = nullptr;
-        return -EINVAL;
-    }
-    *client_context = static_cast<void*>(ctx);
-    return 0;
+        catch (...)
+        {
+            *client_context = nullptr;
+            return -EINVAL;
+        }
+        return 0;
+    });
 }
 
 void mctpw_process(void* client_context)
 {
-    if (!client_context)
+    std::shared_ptr<clientContext> ctx;
     {
-        return;
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        auto it = manager.clients.find(client_context);
+        if (it == manager.clients.end())
+        {
+            return;
+        }
+        /* keep context alive until loop returns, client may be unregistered
+         * from a callback or from another thread */
+        ctx = it->second;
     }
 
-    clientContext* ctx = static_cast<clientContext*>(client_context);
+    if (manager.threaded)
+    {
+        /* loop is run by worker threads, only wait for unregistration */
+        std::unique_lock<std::mutex> lock(manager.mutex);
+        manager.completionsCond.wait(lock,
+                                     [&ctx]() { return ctx->stopping.load(); });
+        return;
+    }
 
-    (ctx->io_context.get())->run();
+    manager.tracked = true;
+    while (!ctx->stopping)
+    {
+        if ((ctx->io_context.get())->run_one() == 0)
+        {
+            break;
+        }
+    }
     return;
 }
 
@@ -509,6 +1414,11 @@ int mctpw_process_one(void* client_context)
 
     clientContext* ctx = static_cast<clientContext*>(client_context);
 
+    if (manager.threaded)
+    {
+        return 0;
+    }
+    manager.tracked = true;
     ret = (ctx->io_context.get())->poll_one();
     (ctx->io_context.get())->restart();
     return ret;
@@ -516,20 +1426,80 @@ int mctpw_process_one(void* client_context)
 
 void mctpw_unregister_client(void* client_context)
 {
-    if (!client_context)
-    {
-        return;
-    }
-    clientContext* ctx = static_cast<clientContext*>(client_context);
-    /* stop io */
-    (ctx->io_context.get())->stop();
-    /* before delete ctx wait for io stopped */
-    while (!(ctx->io_context.get())->stopped())
+    /* matches are removed from loop thread in threaded mode */
+    run_on_loop([client_context]() {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        auto it = manager.clients.find(client_context);
+        if (it == manager.clients.end())
+        {
+            return;
+        }
+        std::shared_ptr<clientContext> ctx = it->second;
+        manager.clients.erase(it);
+
+        serviceContext* service = ctx->service;
+        auto range =
+            service->clients.equal_range(static_cast<uint8_t>(ctx->type));
+        for (auto i = range.first; i != range.second; i++)
+        {
+            if (i->second == ctx)
+            {
+                service->clients.erase(i);
+                break;
+            }
+        }
+        if (ctx->rx_cb)
+        {
+            remove_receive_match(service, *ctx);
+        }
+        if (service->clients.empty())
+        {
+            manager.services.erase(service->name);
+        }
+
+        if (ctx->notice.timer)
+        {
+            ctx->notice.timer->cancel();
+        }
+
+        /* let mctpw_process() dispatching on behalf of this client return */
+        ctx->stopping = true;
+        manager.completionsCond.notify_all();
+        if (manager.threaded)
+        {
+            /* connection is kept until worker threads are stopped */
+            return;
+        }
+        if (manager.clients.empty())
+        {
+            /* last client, release shared connection and stop io */
+            manager.connection.reset();
+            (ctx->io_context.get())->stop();
+            manager.io_context.reset();
+        }
+        else
+        {
+            boost::asio::post(*(ctx->io_context), []() {});
+            manager.pendingHandlers = true;
+        }
+    });
+}
+
+int mctpw_set_reconfiguration_callback(
+    void* client_context, mctpw_reconfiguration_delta_callback_t cb,
+    unsigned quiet_period_ms)
+{
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    auto it = manager.clients.find(client_context);
+    if (it == manager.clients.end())
     {
-        usleep(100);
+        return -EINVAL;
     }
-    delete ctx;
-    return;
+
+    reconfigurationNotice& notice = it->second->notice;
+    notice.cb = cb;
+    notice.quietPeriod = std::chrono::milliseconds(quiet_period_ms);
+    return 0;
 }
 
 int mctpw_get_endpoint_list(void* client_context, mctpw_eid_t* eids,
@@ -548,56 +1518,24 @@ int mctpw_get_endpoint_list(void* client_context, mctpw_eid_t* eids,
     try
     {
         clientContext* ctx = static_cast<clientContext*>(client_context);
-        /*
-         * response format:
-         * DICT[STRING,DICT[STRING,ARRAY[STRING]]] dictionary of path ->
-         * services
-         */
-        DictType<std::string, DictType<std::string, std::vector<std::string>>>
-            values;
-
-        std::vector<std::string> interfaces;
-        interfaces.push_back("xyz.openbmc_project.MCTP.Endpoint");
-
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
-                    "xyz.openbmc_project.ObjectMapper",
-                    "/xyz/openbmc_project/object_mapper",
-                    "xyz.openbmc_project.ObjectMapper", "GetSubTree", values,
-                    "/xyz/openbmc_project/mctp/device", 0, interfaces);
-        for (auto& path : values)
-        {
-            /* ignore entry if service name doesn't match */
-            if (path.second.find(ctx->service_h->second.c_str()) ==
-                path.second.end())
+        refresh_endpoint_directory(ctx);
+
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        EndpointDirectory& directory = ctx->service->directory;
+
+        for (auto& i : directory.endpoints)
+        {
+            if (!i.second.isEndpoint)
             {
                 continue;
             }
-
-            std::string spath = path.first;
-
-            /* format of endpoint path: path/Eid */
-            std::vector<std::string> splitted;
-            boost::split(splitted, spath, boost::is_any_of("/"));
-            if (splitted.size())
+            if (*num < max)
             {
-                try
-                {
-                    /* take the last element and convert it to eid */
-                    if (*num < max)
-                    {
-                        eids[(*num)++] = static_cast<mctpw_eid_t>(
-                            std::stoi(splitted[splitted.size() - 1]));
-                    }
-                    else
-                    {
-                        unhandled++;
-                    }
-                }
-                catch (std::exception& e)
-                {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        e.what());
-                }
+                eids[(*num)++] = i.first;
+            }
+            else
+            {
+                unhandled++;
             }
         }
     }
@@ -619,12 +1557,6 @@ int mctpw_get_matching_endpoint_list(void* client_context, mctpw_eid_t* eids,
     unsigned max;
     int unhandled = 0;
 
-    static const std::unordered_map<mctpw_message_type_t, const std::string>
-        msgTypeToPropertyName = {
-            {PLDM, "PLDM"},         {NCSI, "NCSI"},
-            {ETHERNET, "Ethernet"}, {NVME_MGMT_MSG, "NVMeMgmtMsg"},
-            {SPDM, "SPDM "},        {VDPCI, "VDPCI"},
-            {VDIANA, "VDIANA"}};
     if (!client_context || !num || !eids || *num == 0)
     {
         return -EINVAL;
@@ -636,59 +1568,25 @@ int mctpw_get_matching_endpoint_list(void* client_context, mctpw_eid_t* eids,
     try
     {
         clientContext* ctx = static_cast<clientContext*>(client_context);
-        DictType<sdbusplus::message::object_path,
-                 DictType<std::string,
-                          DictType<std::string, MctpPropertiesVariantType>>>
-            values;
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
-                    ctx->service_h->second.c_str(), "/xyz/openbmc_project/mctp",
-                    "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
-                    values);
+        refresh_endpoint_directory(ctx);
 
-        for (auto& path : values)
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        EndpointDirectory& directory = ctx->service->directory;
+
+        for (auto& i : directory.endpoints)
         {
-            std::string spath = path.first;
-            DictType<std::string,
-                     DictType<std::string, MctpPropertiesVariantType>>
-                interface;
-            if (path.second.find("xyz.openbmc_project.MCTP.Endpoint") !=
-                path.second.end())
+            if (!i.second.isEndpoint ||
+                !supports_message_type(i.second.properties, ctx->type))
             {
-                try
-                {
-                    DictType<std::string, MctpPropertiesVariantType> msgIf;
-                    /* SupportedMessageTypes interface should be present for
-                     * each endpoint */
-                    msgIf = path.second.at(
-                        "xyz.openbmc_project.MCTP.SupportedMessageTypes");
-                    MctpPropertiesVariantType pv;
-                    pv = msgIf.at(msgTypeToPropertyName.at(ctx->type));
-
-                    if (std::get<bool>(pv) == true)
-                    {
-                        /* format of of endpoint path: path/Eid */
-                        std::vector<std::string> splitted;
-                        boost::split(splitted, spath, boost::is_any_of("/"));
-                        if (splitted.size())
-                        {
-                            /* take the last element and convert it to eid */
-                            if (*num < max)
-                            {
-                                eids[(*num)++] = static_cast<mctpw_eid_t>(
-                                    std::stoi(splitted[splitted.size() - 1]));
-                            }
-                            else
-                            {
-                                unhandled++;
-                            }
-                        }
-                    }
-                }
-                catch (std::exception& e)
-                {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        e.what());
-                }
+                continue;
+            }
+            if (*num < max)
+            {
+                eids[(*num)++] = i.first;
+            }
+            else
+            {
+                unhandled++;
             }
         }
     }
@@ -705,57 +1603,111 @@ int mctpw_get_matching_endpoint_list(void* client_context, mctpw_eid_t* eids,
     return unhandled;
 }
 
-int mctpw_get_endpoint_properties(void* client_context, mctpw_eid_t eid,
-                                  mctpw_endpoint_properties_t* properties)
+int mctpw_get_endpoint_properties(void* client_context, mctpw_eid_t eid,
+                                  mctpw_endpoint_properties_t* properties)
+{
+    if (!client_context || !properties)
+    {
+        return -EINVAL;
+    }
+
+    try
+    {
+        clientContext* ctx = static_cast<clientContext*>(client_context);
+        refresh_endpoint_directory(ctx);
+
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        EndpointDirectory& directory = ctx->service->directory;
+
+        auto entry = directory.endpoints.find(eid);
+        if (entry == directory.endpoints.end() || !entry->second.isEndpoint)
+        {
+            return -EINVAL;
+        }
+        *properties = entry->second.properties;
+        // todo: vendor_type and vendor_type_count
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EINVAL;
+    }
+    catch (...)
+    {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/* Status reported to callbacks and completions is negative errno, method call
+ * errors carry positive errno or an error outside of errno range */
+static int method_call_status(const boost::system::error_code& ec)
+{
+    if ((ec.category() == boost::system::system_category() ||
+         ec.category() == boost::system::generic_category()) &&
+        ec.value() > 0)
+    {
+        return -ec.value();
+    }
+    return -EIO;
+}
+
+static std::vector<uint8_t> make_payload_vector(const clientContext* ctx,
+                                                const uint8_t* payload,
+                                                unsigned payload_length)
+{
+    std::vector<uint8_t> payload_vector;
+
+    payload_vector.reserve(5 + payload_length);
+    payload_vector.push_back(static_cast<uint8_t>(ctx->type));
+    payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id));
+    payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id >> 8));
+    payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_message_type));
+    payload_vector.push_back(
+        static_cast<uint8_t>(ctx->vendor_message_type >> 8));
+    payload_vector.insert(payload_vector.end(), payload,
+                          payload + payload_length);
+    return payload_vector;
+}
+
+/* Appends vendor header and payload fragments directly into message buffer,
+ * without building intermediate vector */
+static void append_payload_iov(sdbusplus::message::message& msg,
+                               const clientContext* ctx,
+                               const struct iovec* iov, unsigned iovcnt)
 {
-    if (!client_context || !properties)
+    size_t length = 0;
+    for (unsigned n = 0; n < iovcnt; n++)
     {
-        return -EINVAL;
+        length += iov[n].iov_len;
     }
 
-    try
-    {
-        clientContext* ctx = static_cast<clientContext*>(client_context);
-        /*
-         *  response format:
-         *  <DICT<STRING,VARIANT> objpath interfaces_and_properties
-         */
-        DictType<std::string, MctpPropertiesVariantType> props;
-        std::string object =
-            "/xyz/openbmc_project/mctp/device/" + std::to_string(eid);
-
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
-                    ctx->service_h->second.c_str(), object.c_str(),
-                    "org.freedesktop.DBus.Properties", "GetAll", props,
-                    "xyz.openbmc_project.MCTP.SupportedMessageTypes");
-
-        properties->mctp_control = std::get<bool>(props.at("MctpControl"));
-        properties->pldm = std::get<bool>(props.at("PLDM"));
-        properties->ncsi = std::get<bool>(props.at("NCSI"));
-        properties->ethernet = std::get<bool>(props.at("Ethernet"));
-        properties->nvme_mgmt_msg = std::get<bool>(props.at("NVMeMgmtMsg"));
-        properties->spdm = std::get<bool>(props.at("SPDM"));
-        properties->vdpci = std::get<bool>(props.at("VDPCI"));
-        properties->vdiana = std::get<bool>(props.at("VDIANA"));
-
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
-                    ctx->service_h->second.c_str(), object.c_str(),
-                    "org.freedesktop.DBus.Properties", "GetAll", props,
-                    "xyz.openbmc_project.MCTP.Endpoint");
-
-        properties->network_id = std::get<uint16_t>(props.at("NetworkId"));
-        // todo: uuid, vendor_type and vendor_type_count
-    }
-    catch (std::exception& e)
+    uint8_t header[] = {
+        static_cast<uint8_t>(ctx->type),
+        static_cast<uint8_t>(ctx->vendor_id),
+        static_cast<uint8_t>(ctx->vendor_id >> 8),
+        static_cast<uint8_t>(ctx->vendor_message_type),
+        static_cast<uint8_t>(ctx->vendor_message_type >> 8)};
+    void* space = nullptr;
+    int r = sd_bus_message_append_array_space(msg.get(), 'y',
+                                              sizeof(header) + length, &space);
+    if (r < 0)
     {
-        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
-        return -EINVAL;
+        mctpw_exception err(-r, "Append payload failed:");
+        throw err;
     }
-    catch (...)
+
+    uint8_t* dst = static_cast<uint8_t*>(space);
+    std::memcpy(dst, header, sizeof(header));
+    dst += sizeof(header);
+    for (unsigned n = 0; n < iovcnt; n++)
     {
-        return -EINVAL;
+        if (iov[n].iov_len)
+        {
+            std::memcpy(dst, iov[n].iov_base, iov[n].iov_len);
+            dst += iov[n].iov_len;
+        }
     }
-    return 0;
 }
 
 static void do_send_message_payload(boost::asio::yield_context yield,
@@ -766,22 +1718,11 @@ static void do_send_message_payload(boost::asio::yield_context yield,
                                     async_operation_status_cb cb)
 {
     boost::system::error_code ec;
+    int status = -EIO;
     try
     {
-        std::vector<uint8_t> payload_vector;
-
-        payload_vector.push_back(static_cast<uint8_t>(ctx->type));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id >> 8));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type >> 8));
-
-        for (unsigned n = 0; n < payload_length; n++)
-        {
-            payload_vector.push_back(payload[n]);
-        }
+        std::vector<uint8_t> payload_vector =
+            make_payload_vector(ctx, payload, payload_length);
 
         int response = ctx->connection->yield_method_call<int>(
             yield, ec, ctx->service_h->second.c_str(),
@@ -789,21 +1730,18 @@ static void do_send_message_payload(boost::asio::yield_context yield,
             "SendMctpMessagePayload", dst_eid, tag, tag_owner, payload_vector);
         if (ec)
         {
-            cb(ec.value(), user_ctx);
-            return;
+            status = method_call_status(ec);
         }
-        if (response == 0)
+        else if (response == 0)
         {
-            cb(0, user_ctx);
-            return;
+            status = 0;
         }
-        cb(-EIO, user_ctx);
-        return;
     }
     catch (...)
     {
-        cb(-EIO, user_ctx);
+        status = -EIO;
     }
+    run_callback([cb, status, user_ctx]() { cb(status, user_ctx); });
 }
 
 int mctpw_async_send_message(void* client_context, mctpw_eid_t dst_eid,
@@ -832,6 +1770,7 @@ int mctpw_async_send_message(void* client_context, mctpw_eid_t dst_eid,
                                         tag_owner, tag, payload, payload_length,
                                         cb);
             });
+        manager.pendingHandlers = true;
 
         return 0;
     }
@@ -851,11 +1790,34 @@ int mctpw_send_message(void* client_context, mctpw_eid_t dst_eid,
                        bool tag_owner, uint8_t tag, uint8_t* payload,
                        unsigned payload_length)
 {
-    if (!client_context || !payload)
+    if (!payload)
+    {
+        return -EINVAL;
+    }
+
+    struct iovec iov = {payload, payload_length};
+    return mctpw_send_message_iov(client_context, dst_eid, tag_owner, tag, &iov,
+                                  1);
+}
+
+int mctpw_send_message_iov(void* client_context, mctpw_eid_t dst_eid,
+                           bool tag_owner, uint8_t tag,
+                           const struct iovec* iov, unsigned iovcnt)
+{
+    if (!client_context || !iov)
     {
         return -EINVAL;
     }
 
+    size_t payload_length = 0;
+    for (unsigned n = 0; n < iovcnt; n++)
+    {
+        if (!iov[n].iov_base && iov[n].iov_len)
+        {
+            return -EINVAL;
+        }
+        payload_length += iov[n].iov_len;
+    }
     if (payload_length == 0)
     {
         return 0;
@@ -863,25 +1825,21 @@ int mctpw_send_message(void* client_context, mctpw_eid_t dst_eid,
     try
     {
         clientContext* ctx = static_cast<clientContext*>(client_context);
-        int response;
-        std::vector<uint8_t> payload_vector;
 
-        payload_vector.push_back(static_cast<uint8_t>(ctx->type));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id >> 8));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type >> 8));
-
-        for (unsigned n = 0; n < payload_length; n++)
-        {
-            payload_vector.push_back(payload[n]);
-        }
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
+        int response = call_blocking(
+            [&](sdbusplus::bus::bus& bus) {
+                auto msg = bus.new_method_call(
                     ctx->service_h->second.c_str(), "/xyz/openbmc_project/mctp",
-                    "xyz.openbmc_project.MCTP.Base", "SendMctpMessagePayload",
-                    response, dst_eid, tag, tag_owner, payload_vector);
+                    "xyz.openbmc_project.MCTP.Base", "SendMctpMessagePayload");
+                msg.append(dst_eid, tag, tag_owner);
+                append_payload_iov(msg, ctx, iov, iovcnt);
+                return msg;
+            },
+            [](sdbusplus::message::message& reply) {
+                int result;
+                reply.read(result);
+                return result;
+            });
         if (response == 0)
         {
             return 0;
@@ -905,20 +1863,12 @@ static void do_send_receive_atomic_message(
     unsigned timeout, send_receive_atomic_cb cb)
 {
     boost::system::error_code ec;
+    int status = -EIO;
+    std::vector<uint8_t> response_vector;
     try
     {
-        std::vector<uint8_t> payload_vector, response_vector;
-
-        payload_vector.push_back(static_cast<uint8_t>(ctx->type));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id >> 8));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type >> 8));
-
-        for (unsigned n = 0; n < payload_length; n++)
-            payload_vector.push_back(payload[n]);
+        std::vector<uint8_t> payload_vector =
+            make_payload_vector(ctx, payload, payload_length);
 
         response_vector =
             ctx->connection->yield_method_call<std::vector<uint8_t>>(
@@ -928,21 +1878,24 @@ static void do_send_receive_atomic_message(
                 static_cast<uint16_t>(timeout));
         if (ec)
         {
-            cb(ec.value(), user_ctx, nullptr, 0);
-            return;
+            status = method_call_status(ec);
+            response_vector.clear();
         }
-        if (response_vector.size())
+        else if (response_vector.size())
         {
-            cb(0, user_ctx, response_vector.data(), response_vector.size());
-            return;
+            status = 0;
         }
-        cb(-EIO, user_ctx, nullptr, 0);
-        return;
     }
     catch (...)
     {
-        cb(-EIO, user_ctx, nullptr, 0);
+        status = -EIO;
+        response_vector.clear();
     }
+    run_callback([cb, status, user_ctx,
+                  response = std::move(response_vector)]() mutable {
+        cb(status, user_ctx, response.size() ? response.data() : nullptr,
+           response.size());
+    });
 }
 
 int mctpw_async_send_receive_atomic_message(
@@ -970,6 +1923,7 @@ int mctpw_async_send_receive_atomic_message(
                     yield, ctx, user_ctx, dst_eid, request_payload,
                     request_payload_length, timeout, cb);
             });
+        manager.pendingHandlers = true;
 
         return 0;
     }
@@ -992,12 +1946,40 @@ int mctpw_send_receive_atomic_message(void* client_context, mctpw_eid_t dst_eid,
                                       unsigned* response_payload_length,
                                       unsigned timeout)
 {
-    if (!client_context || !request_payload || !response_payload ||
+    if (!request_payload)
+    {
+        return -EINVAL;
+    }
+
+    struct iovec iov = {request_payload, request_payload_length};
+    return mctpw_send_receive_atomic_message_iov(
+        client_context, dst_eid, &iov, 1, response_payload,
+        response_payload_length, timeout);
+}
+
+int mctpw_send_receive_atomic_message_iov(void* client_context,
+                                          mctpw_eid_t dst_eid,
+                                          const struct iovec* iov,
+                                          unsigned iovcnt,
+                                          uint8_t* response_payload,
+                                          unsigned* response_payload_length,
+                                          unsigned timeout)
+{
+    if (!client_context || !iov || !response_payload ||
         !response_payload_length)
     {
         return -EINVAL;
     }
 
+    size_t request_payload_length = 0;
+    for (unsigned n = 0; n < iovcnt; n++)
+    {
+        if (!iov[n].iov_base && iov[n].iov_len)
+        {
+            return -EINVAL;
+        }
+        request_payload_length += iov[n].iov_len;
+    }
     if (request_payload_length == 0)
     {
         return 0;
@@ -1005,46 +1987,451 @@ int mctpw_send_receive_atomic_message(void* client_context, mctpw_eid_t dst_eid,
     try
     {
         clientContext* ctx = static_cast<clientContext*>(client_context);
-        std::vector<uint8_t> payload_vector, response_vector;
-
-        payload_vector.push_back(static_cast<uint8_t>(ctx->type));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id));
-        payload_vector.push_back(static_cast<uint8_t>(ctx->vendor_id >> 8));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type));
-        payload_vector.push_back(
-            static_cast<uint8_t>(ctx->vendor_message_type >> 8));
-
-        for (unsigned n = 0; n < request_payload_length; n++)
-            payload_vector.push_back(request_payload[n]);
+        const unsigned buffer_length = *response_payload_length;
 
-        call_method(static_cast<sdbusplus::bus::bus&>(*(ctx->connection)),
+        size_t required_length = call_blocking(
+            [&](sdbusplus::bus::bus& bus) {
+                auto msg = bus.new_method_call(
                     ctx->service_h->second.c_str(), "/xyz/openbmc_project/mctp",
                     "xyz.openbmc_project.MCTP.Base",
-                    "SendReceiveMctpMessagePayload", response_vector, dst_eid,
-                    payload_vector, static_cast<uint16_t>(timeout));
+                    "SendReceiveMctpMessagePayload");
+                msg.append(dst_eid);
+                append_payload_iov(msg, ctx, iov, iovcnt);
+                msg.append(static_cast<uint16_t>(timeout));
+                return msg;
+            },
+            [&](sdbusplus::message::message& reply) {
+                /* response is copied from message buffer straight to caller
+                 * buffer */
+                const void* response = nullptr;
+                size_t response_length = 0;
+                int r = sd_bus_message_read_array(reply.get(), 'y', &response,
+                                                  &response_length);
+                if (r < 0)
+                {
+                    mctpw_exception err(-r, "Read response failed:");
+                    throw err;
+                }
+                if (response_length && buffer_length)
+                {
+                    std::memcpy(response_payload, response,
+                                std::min<size_t>(response_length,
+                                                 buffer_length));
+                }
+                return response_length;
+            });
+        /* response is truncated to buffer, caller learns required length */
+        *response_payload_length = static_cast<unsigned>(required_length);
+        return required_length > buffer_length ? -EMSGSIZE : 0;
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EINVAL;
+    }
+    catch (...)
+    {
+        return -EINVAL;
+    }
+    return -EIO;
+}
+
+static void pump_requests(const std::shared_ptr<clientContext>& ctx,
+                          mctpw_eid_t eid);
+
+static void do_windowed_request(boost::asio::yield_context yield,
+                                std::shared_ptr<clientContext> ctx,
+                                const mctpw_request_t& request)
+{
+    boost::system::error_code ec;
+    mctpw_completion_t completion{};
 
-        if (response_vector.size() && *response_payload_length)
+    completion.dst_eid = request.dst_eid;
+    completion.user_ctx = request.user_ctx;
+    try
+    {
+        std::vector<uint8_t> response_vector =
+            ctx->connection->yield_method_call<std::vector<uint8_t>>(
+                yield, ec, ctx->service_h->second.c_str(),
+                "/xyz/openbmc_project/mctp", "xyz.openbmc_project.MCTP.Base",
+                "SendReceiveMctpMessagePayload", request.dst_eid,
+                make_payload_vector(ctx.get(), request.request_payload,
+                                    request.request_payload_length),
+                static_cast<uint16_t>(request.timeout));
+        if (ec)
+        {
+            completion.status = method_call_status(ec);
+        }
+        else if (response_vector.empty())
+        {
+            completion.status = -EIO;
+        }
+        else
         {
-            unsigned n = 0;
-            for (auto& i : response_vector)
+            /* same contract as mctpw_send_receive_atomic_message() */
+            const unsigned length = static_cast<unsigned>(
+                std::min<size_t>(response_vector.size(),
+                                 request.response_payload_length));
+            std::copy_n(response_vector.begin(), length,
+                        request.response_payload);
+            if (length < response_vector.size())
             {
-                response_payload[n++] = i;
-                if (n >= *response_payload_length)
-                    break;
+                completion.status = -EMSGSIZE;
             }
-            *response_payload_length = n;
+            completion.response_payload_length =
+                static_cast<unsigned>(response_vector.size());
+        }
+    }
+    catch (...)
+    {
+        completion.status = -EIO;
+    }
+
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    if (ctx->stopping)
+    {
+        return;
+    }
+    ctx->requests.endpoints[request.dst_eid].inFlight--;
+    ctx->requests.outstanding--;
+    ctx->requests.completions.push_back(completion);
+    manager.completionsCond.notify_all();
+    pump_requests(ctx, request.dst_eid);
+}
+
+static void pump_requests(const std::shared_ptr<clientContext>& ctx,
+                          mctpw_eid_t eid)
+{
+    endpointRequests& endpoint = ctx->requests.endpoints[eid];
+
+    while (endpoint.inFlight < ctx->requests.window &&
+           !endpoint.pending.empty())
+    {
+        mctpw_request_t request = endpoint.pending.front();
+        endpoint.pending.pop_front();
+        endpoint.inFlight++;
+
+        boost::asio::spawn(*(ctx->io_context),
+                           [ctx, request](boost::asio::yield_context yield) {
+                               do_windowed_request(yield, ctx, request);
+                           });
+        manager.pendingHandlers = true;
+    }
+}
+
+int mctpw_set_request_window(void* client_context, unsigned window)
+{
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    auto it = manager.clients.find(client_context);
+    if (it == manager.clients.end() || window == 0 ||
+        window > MCTPW_MAX_REQUEST_WINDOW)
+    {
+        return -EINVAL;
+    }
+
+    try
+    {
+        std::shared_ptr<clientContext> ctx = it->second;
+
+        ctx->requests.window = window;
+        for (auto& endpoint : ctx->requests.endpoints)
+        {
+            pump_requests(ctx, endpoint.first);
         }
-        return 0;
     }
     catch (std::exception& e)
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EIO;
+    }
+    return 0;
+}
+
+int mctpw_submit_requests(void* client_context,
+                          const mctpw_request_t* requests, unsigned count)
+{
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    auto it = manager.clients.find(client_context);
+    if (it == manager.clients.end() || (!requests && count))
+    {
         return -EINVAL;
     }
-    catch (...)
+
+    /* reject whole batch if any of requests is invalid */
+    for (unsigned n = 0; n < count; n++)
+    {
+        if (!requests[n].request_payload ||
+            requests[n].request_payload_length == 0 ||
+            !requests[n].response_payload ||
+            requests[n].response_payload_length == 0)
+        {
+            return -EINVAL;
+        }
+    }
+
+    try
+    {
+        std::shared_ptr<clientContext> ctx = it->second;
+
+        for (unsigned n = 0; n < count; n++)
+        {
+            ctx->requests.endpoints[requests[n].dst_eid].pending.push_back(
+                requests[n]);
+            ctx->requests.outstanding++;
+        }
+        for (unsigned n = 0; n < count; n++)
+        {
+            pump_requests(ctx, requests[n].dst_eid);
+        }
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+int mctpw_reap_completions(void* client_context,
+                           mctpw_completion_t* completions, unsigned max,
+                           unsigned wait_nr)
+{
+    std::unique_lock<std::mutex> lock(manager.mutex);
+    auto it = manager.clients.find(client_context);
+    if (it == manager.clients.end() || !completions || max == 0)
     {
         return -EINVAL;
     }
-    return -EIO;
+
+    std::shared_ptr<clientContext> ctx = it->second;
+    requestQueue& queue = ctx->requests;
+
+    wait_nr = std::min(wait_nr, max);
+    if (manager.threaded)
+    {
+        manager.completionsCond.wait(lock, [&queue, &ctx, wait_nr]() {
+            return queue.completions.size() >= wait_nr || !queue.outstanding ||
+                   ctx->stopping;
+        });
+    }
+    while (queue.completions.size() < wait_nr && queue.outstanding &&
+           !ctx->stopping && !manager.threaded)
+    {
+        /* handlers completing requests take the lock */
+        lock.unlock();
+        size_t handled = (ctx->io_context.get())->run_one();
+        lock.lock();
+        if (handled == 0)
+        {
+            break;
+        }
+    }
+
+    unsigned n = 0;
+    while (n < max && !queue.completions.empty())
+    {
+        completions[n++] = queue.completions.front();
+        queue.completions.pop_front();
+    }
+    return static_cast<int>(n);
+}
+
+int mctpw_start_worker_threads(unsigned threads)
+{
+    if (threads == 0)
+    {
+        return -EINVAL;
+    }
+
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    if (manager.threaded)
+    {
+        return -EALREADY;
+    }
+
+    try
+    {
+        create_connection();
+        manager.work.emplace(manager.io_context->get_executor());
+        manager.workers = std::make_unique<boost::asio::thread_pool>(threads);
+        manager.loopThread = std::thread([io = manager.io_context]() {
+            while (!io->stopped())
+            {
+                try
+                {
+                    io->run();
+                }
+                catch (std::exception& e)
+                {
+                    phosphor::logging::log<phosphor::logging::level::ERR>(
+                        e.what());
+                }
+            }
+        });
+        /* loop runs all the time, directories are always up to date */
+        manager.tracked = true;
+        manager.threaded = true;
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        manager.work.reset();
+        manager.workers.reset();
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+void mctpw_stop_worker_threads(void)
+{
+    if (!manager.threaded || on_loop_thread())
+    {
+        return;
+    }
+
+    /* callbacks may still make blocking calls served by loop thread, drain
+     * workers first and stop loop afterwards */
+    manager.workers->join();
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        manager.work.reset();
+        manager.io_context->stop();
+    }
+    /* handlers on loop thread may wait for the lock, join without it */
+    manager.loopThread.join();
+
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    manager.workers.reset();
+    manager.threaded = false;
+    manager.tracked = false;
+    manager.io_context->restart();
+    if (manager.clients.empty())
+    {
+        manager.connection.reset();
+        manager.io_context.reset();
+    }
+}
+
+int mctpw_get_fd(void* client_context)
+{
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    if (manager.clients.find(client_context) == manager.clients.end())
+    {
+        return -EINVAL;
+    }
+    return sd_bus_get_fd(manager.connection->get());
+}
+
+int mctpw_get_events(void* client_context, uint64_t* timeout_usec)
+{
+    std::lock_guard<std::mutex> lock(manager.mutex);
+    if (manager.clients.find(client_context) == manager.clients.end())
+    {
+        return -EINVAL;
+    }
+
+    sd_bus* bus = manager.connection->get();
+    int events = sd_bus_get_events(bus);
+    if (events < 0 || !timeout_usec)
+    {
+        return events;
+    }
+
+    if (manager.pendingHandlers)
+    {
+        *timeout_usec = 0;
+        return events;
+    }
+
+    /* asio timers don't make fd ready, wake up for network change notice */
+    std::optional<std::chrono::steady_clock::duration> noticeTimeout;
+    for (auto& client : manager.clients)
+    {
+        const reconfigurationNotice& notice = client.second->notice;
+        if (notice.pending && notice.quietPeriod.count())
+        {
+            auto left = std::max(notice.deadline -
+                                     std::chrono::steady_clock::now(),
+                                 std::chrono::steady_clock::duration::zero());
+            if (!noticeTimeout || left < *noticeTimeout)
+            {
+                noticeTimeout = left;
+            }
+        }
+    }
+
+    /* sd-bus reports absolute CLOCK_MONOTONIC deadline, 0 when messages are
+     * already queued and UINT64_MAX when there is no deadline */
+    uint64_t deadline = UINT64_MAX;
+    int r = sd_bus_get_timeout(bus, &deadline);
+    if (r < 0)
+    {
+        return r;
+    }
+    if (deadline == UINT64_MAX)
+    {
+        *timeout_usec = UINT64_MAX;
+    }
+    else
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t nowUsec = static_cast<uint64_t>(now.tv_sec) * 1000000 +
+                           static_cast<uint64_t>(now.tv_nsec) / 1000;
+        *timeout_usec = deadline > nowUsec ? deadline - nowUsec : 0;
+    }
+
+    if (noticeTimeout)
+    {
+        /* round up, waking before deadline would find nothing to do */
+        uint64_t noticeUsec = static_cast<uint64_t>(
+            std::chrono::ceil<std::chrono::microseconds>(*noticeTimeout)
+                .count());
+        *timeout_usec = std::min(*timeout_usec, noticeUsec);
+    }
+    return events;
+}
+
+int mctpw_dispatch(void* client_context)
+{
+    std::shared_ptr<clientContext> ctx;
+    {
+        std::lock_guard<std::mutex> lock(manager.mutex);
+        auto it = manager.clients.find(client_context);
+        if (it == manager.clients.end())
+        {
+            return -EINVAL;
+        }
+        if (manager.threaded)
+        {
+            return -EBUSY;
+        }
+        /* keep connection alive, client may be unregistered from callback */
+        ctx = it->second;
+    }
+
+    manager.tracked = true;
+    manager.pendingHandlers = false;
+
+    int handled = 0;
+    try
+    {
+        handled += static_cast<int>(ctx->io_context->poll());
+        ctx->io_context->restart();
+        /* messages already read by blocking calls don't make fd readable,
+         * process sd-bus queues directly so they are not left behind */
+        while (!ctx->stopping &&
+               sd_bus_process(ctx->connection->get(), nullptr) > 0)
+        {
+            handled++;
+        }
+        handled += static_cast<int>(ctx->io_context->poll());
+        ctx->io_context->restart();
+    }
+    catch (std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(e.what());
+        return -EIO;
+    }
+    return handled;
 }
@@ -28,12 +28,13 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define _VERSION 0x010101
+#define _VERSION 0x010700
 
 typedef uint8_t mctpw_eid_t;
 
@@ -81,12 +82,66 @@ typedef struct
     bool vdiana;
 } mctpw_endpoint_properties_t;
 
+/** @brief Upper limit of requests in flight to one endpoint, MCTP tag is 3 bit
+ * wide */
+#define MCTPW_MAX_REQUEST_WINDOW 8
+
+/** @brief Submission entry of windowed request API,
+ * @see mctpw_submit_requests() */
+typedef struct
+{
+    /** @brief destination endpoint eid */
+    mctpw_eid_t dst_eid;
+    /** @brief request payload, must stay valid until request is completed */
+    uint8_t* request_payload;
+    unsigned request_payload_length;
+    /** @brief response buffer, must stay valid until request is completed */
+    uint8_t* response_payload;
+    /** @brief length of response buffer */
+    unsigned response_payload_length;
+    /** @brief timeout in ms */
+    unsigned timeout;
+    /** @brief user context data, returned in completion entry */
+    const void* user_ctx;
+} mctpw_request_t;
+
+/** @brief Completion entry of windowed request API,
+ * @see mctpw_reap_completions() */
+typedef struct
+{
+    /** @brief 0 if success or negative error code, -EMSGSIZE when response
+     * was truncated to length of response buffer */
+    int status;
+    mctpw_eid_t dst_eid;
+    /** @brief response length, bigger than response buffer when status is
+     * -EMSGSIZE, then only the buffer length was written */
+    unsigned response_payload_length;
+    const void* user_ctx;
+} mctpw_completion_t;
+
+/** @brief Bus entry returned by mctpw_enumerate_buses() */
+typedef struct
+{
+    /** @brief bus handle, @see mctpw_register_client() */
+    void* mctpw_bus_handle;
+    /** @brief SMBus bus number or PCIe bus number, same as bus_index of
+     * mctpw_find_bus_by_binding_type() */
+    unsigned bus;
+} mctpw_bus_info_t;
+
 typedef void (*mctpw_reconfiguration_callback_t)(void* client_context);
 
+/** @brief Network change callback carrying endpoints added and removed since
+ * previous notification, @see mctpw_set_reconfiguration_callback() */
+typedef void (*mctpw_reconfiguration_delta_callback_t)(
+    void* client_context, const mctpw_eid_t* added_eids, unsigned added_count,
+    const mctpw_eid_t* removed_eids, unsigned removed_count);
+
 typedef void (*mctpw_receive_message_callback_t)(
     void* client_context, mctpw_eid_t src_eid, bool tag_owner, uint8_t tag,
     uint8_t* payload, unsigned payload_length, int error);
 
+/* ec is 0 if success or negative error code */
 typedef void (*async_operation_status_cb)(int ec, const void* user_ctx);
 typedef void (*send_receive_atomic_cb)(int ec, const void* user_ctx,
                                        uint8_t* response,
@@ -104,6 +159,22 @@ typedef void (*send_receive_atomic_cb)(int ec, const void* user_ctx,
 int mctpw_find_bus_by_binding_type(mctpw_binding_type_t binding_type,
                                    unsigned bus_index, void** mctpw_bus_handle);
 
+/**
+ * @brief Get all MCTP buses of given binding in one call.
+ * @param binding_type Requested binding type
+ * @param bus_list Table to write bus entries
+ * @param num input:number of entries in the bus_list table,
+ *            output:number of entries already written to bus_list table
+ * @return 0 if success
+ *         >0 number of buses not written due to lack of space in the table
+ *         or negative error code
+ * @note Buses are read once and cached until an mctp service is started or
+ * stopped, mctpw_find_bus_by_binding_type() is served from the same cache.
+ * Returned handles stay valid for process lifetime.
+ */
+int mctpw_enumerate_buses(mctpw_binding_type_t binding_type,
+                          mctpw_bus_info_t* bus_list, unsigned* num);
+
 /**
  * @brief Register client on the bus for specyfic message type.
  * If message type is vendor defined parameters vendor_id, vendor_message_type,
@@ -136,6 +207,26 @@ int mctpw_register_client(void* mctpw_bus_handle, mctpw_message_type_t type,
  */
 void mctpw_unregister_client(void* client_context);
 
+/**
+ * @brief Set delta callback and quiet period of network change notifications.
+ * Changes are collected until no change arrives for the quiet period and then
+ * delivered with one call of nc_cb passed to mctpw_register_client() and one
+ * call of delta callback.
+ * @param client_context Pointer to client context
+ * @param cb Callback receiving endpoints added and removed since previous
+ *           notification, can be NULL. Notification with empty lists means
+ *           properties of known endpoints changed.
+ * @param quiet_period_ms Quiet period in ms, 0 delivers every change at once
+ *                        (default). Continuous changes postpone notification
+ *                        at most 4 quiet periods.
+ * @note Pending notification deadline is included in timeout returned by
+ * mctpw_get_events()
+ * @return 0 if success or negative error code
+ */
+int mctpw_set_reconfiguration_callback(
+    void* client_context, mctpw_reconfiguration_delta_callback_t cb,
+    unsigned quiet_period_ms);
+
 /**
  * @brief Get list of all endpoints on the bus.
  * @param client_context Pointer to client context
@@ -145,7 +236,10 @@ void mctpw_unregister_client(void* client_context);
  * @return 0 if success
  *         >0 number of eids not written due to lack of space in the table
  *         or negative error code
- * @note Function blocks until response is received
+ * @note Served from endpoint directory kept by the library, first call blocks
+ * until directory is read from mctp daemon. Directory follows daemon signals
+ * once client dispatches them, @see mctpw_process(), until then every call
+ * reads it again.
  */
 int mctpw_get_endpoint_list(void* client_context, mctpw_eid_t* eids,
                             unsigned* num);
@@ -160,7 +254,7 @@ int mctpw_get_endpoint_list(void* client_context, mctpw_eid_t* eids,
  * @return 0 if success
  *         >0 number of eids not written due to lack of space in the table
  *         or negative error code
- * @note Function blocks until response is received
+ * @note Served from endpoint directory, @see mctpw_get_endpoint_list()
  */
 int mctpw_get_matching_endpoint_list(void* client_context, mctpw_eid_t* eids,
                                      unsigned* num);
@@ -171,7 +265,7 @@ int mctpw_get_matching_endpoint_list(void* client_context, mctpw_eid_t* eids,
  * @param eid eid of endpoint
  * @param properties pointer to mctpw_endpoint_properties_t structure for output
  * @return 0 if success or negative error code
- * @note Function blocks until response is received
+ * @note Served from endpoint directory, @see mctpw_get_endpoint_list()
  */
 int mctpw_get_endpoint_properties(void* client_context, mctpw_eid_t eid,
                                   mctpw_endpoint_properties_t* properties);
@@ -196,6 +290,25 @@ int mctpw_send_message(void* client_context, mctpw_eid_t dst_eid,
                        bool tag_owner, uint8_t tag, uint8_t* payload,
                        unsigned payload_length);
 
+/**
+ * @brief Send mctp payload gathered from several buffers to specyfic endpoint
+ * on the bus. Buffers are copied directly into dbus message, e.g. protocol
+ * header and body can be passed without concatenating them first.
+ * @param client_context Pointer to client context
+ * @param dst_eid destination endpoint eid
+ * @param tag_owner indicates if this is request (tag_owner = 1) or reply
+ *                    message (tag_owner = 0)
+ * @param tag numeric tag in range 0..7 be used to identify messages,
+ *              when sending reply this must be same as received tag.
+ * @param iov table of payload fragments, sent in table order
+ * @param iovcnt number of entries in iov table
+ * @note Function blocks until send operation is confirmed
+ * @return 0 if success or negative error code
+ */
+int mctpw_send_message_iov(void* client_context, mctpw_eid_t dst_eid,
+                           bool tag_owner, uint8_t tag,
+                           const struct iovec* iov, unsigned iovcnt);
+
 /**
  * @brief Send mctp payload to specyfic endpoint on the bus.
  * @note Payload start right after 4 byte MCTP header.
@@ -237,7 +350,9 @@ int mctpw_async_send_message(void* client_context, mctpw_eid_t dst_eid,
  *                                output:message length
  * @param timeout timeout in ms
  * @note Function blocks until response is received
- * @return 0 if success or negative error code
+ * @return 0 if success or negative error code, -EMSGSIZE when response
+ * doesn't fit in buffer, response is truncated to buffer length and
+ * response_payload_length is set to required length
  */
 int mctpw_send_receive_atomic_message(void* client_context, mctpw_eid_t dst_eid,
                                       uint8_t* request_payload,
@@ -246,6 +361,32 @@ int mctpw_send_receive_atomic_message(void* client_context, mctpw_eid_t dst_eid,
                                       unsigned* response_payload_length,
                                       unsigned timeout);
 
+/**
+ * @brief Same as mctpw_send_receive_atomic_message() with request gathered
+ * from several buffers. Request fragments are copied directly into dbus
+ * message and response is copied from dbus message directly into response
+ * buffer, no intermediate buffers are allocated.
+ * @param client_context Pointer to client context
+ * @param dst_eid destination endpoint eid
+ * @param iov table of request payload fragments, sent in table order
+ * @param iovcnt number of entries in iov table
+ * @param response_payload response buffer pointer
+ * @param response_payload_length input:length of buffer
+ *                                output:message length
+ * @param timeout timeout in ms
+ * @note Function blocks until response is received
+ * @return 0 if success or negative error code, -EMSGSIZE when response
+ * doesn't fit in buffer, response is truncated to buffer length and
+ * response_payload_length is set to required length
+ */
+int mctpw_send_receive_atomic_message_iov(void* client_context,
+                                          mctpw_eid_t dst_eid,
+                                          const struct iovec* iov,
+                                          unsigned iovcnt,
+                                          uint8_t* response_payload,
+                                          unsigned* response_payload_length,
+                                          unsigned timeout);
+
 /**
  * @brief Send mctp payload to specyfic endpoint on the bus and receive
  * response. This is non blocking function, it sends message and returns
@@ -268,11 +409,58 @@ int mctpw_async_send_receive_atomic_message(
     unsigned request_payload_length, unsigned timeout, const void* user_ctx,
     send_receive_atomic_cb cb);
 
+/**
+ * @brief Set number of requests submitted by mctpw_submit_requests() which
+ * can be in flight to one endpoint at the same time. Default is 1.
+ * @param client_context Pointer to client context
+ * @param window number of requests in range 1..MCTPW_MAX_REQUEST_WINDOW
+ * @return 0 if success or negative error code
+ */
+int mctpw_set_request_window(void* client_context, unsigned window);
+
+/**
+ * @brief Queue requests to be sent to endpoints. Requests to the same endpoint
+ * are sent in order of submission, keeping at most request window of them in
+ * flight, requests to different endpoints are sent independently.
+ * @note Request and response buffers are used until request completion is
+ * reaped, @see mctpw_reap_completions(). Requests are sent while async
+ * handlers are processed.
+ * @param client_context Pointer to client context
+ * @param requests table of requests
+ * @param count number of entries in requests table
+ * @return 0 if success or negative error code, on error none of requests is
+ * queued
+ */
+int mctpw_submit_requests(void* client_context,
+                          const mctpw_request_t* requests, unsigned count);
+
+/**
+ * @brief Reap completions of submitted requests.
+ * @param client_context Pointer to client context
+ * @param completions Table to write completions
+ * @param max number of entries in completions table
+ * @param wait_nr number of completions to wait for, async handlers are
+ * processed until that many completions are available or no more requests
+ * are outstanding. 0 doesn't block.
+ * @return number of completions written or negative error code
+ * @note When wait_nr is not 0 function dispatches handlers of all clients, it
+ * must not be called while other thread is in mctpw_process()
+ */
+int mctpw_reap_completions(void* client_context,
+                           mctpw_completion_t* completions, unsigned max,
+                           unsigned wait_nr);
+
 /**
  * @brief Start process async handlers.
  * @param client_context pointer to client context
  * @note Function blocks current thread, processing loop can be interrupted by
  * unregistering client, @see mctpw_unregister_client()
+ * @note All clients registered in the process share one dbus connection and
+ * event loop, handlers of every client are dispatched by this call. Only one
+ * thread should dispatch at a time.
+ * @note In threaded mode handlers are dispatched by library threads and this
+ * function only waits for client being unregistered,
+ * @see mctpw_start_worker_threads()
  */
 void mctpw_process(void* client_context);
 
@@ -287,6 +475,61 @@ void mctpw_process(void* client_context);
  */
 int mctpw_process_one(void* client_context);
 
+/**
+ * @brief Get file descriptor of dbus connection shared by clients, to drive
+ * library from external event loop (epoll, libevent, sd-event) instead of
+ * mctpw_process().
+ * @param client_context pointer to client context
+ * @return file descriptor or negative error code
+ * @note Descriptor is owned by library and must not be closed, wait for the
+ * events returned by mctpw_get_events() and call mctpw_dispatch()
+ */
+int mctpw_get_fd(void* client_context);
+
+/**
+ * @brief Get events to wait for on descriptor returned by mctpw_get_fd().
+ * Should be called before each wait, after mctpw_dispatch() and after
+ * starting async operations.
+ * @param client_context pointer to client context
+ * @param timeout_usec if not NULL set to time in microseconds after which
+ * mctpw_dispatch() must be called even if descriptor is not ready, 0 when
+ * handlers are ready to be dispatched, UINT64_MAX when there is no deadline.
+ * Deadline of pending network change notification is included.
+ * @return poll() event mask (POLLIN, POLLOUT) or negative error code
+ */
+int mctpw_get_events(void* client_context, uint64_t* timeout_usec);
+
+/**
+ * @brief Dispatch all ready handlers without blocking.
+ * @param client_context pointer to client context
+ * @return number of handlers dispatched or negative error code
+ * @note Dispatches handlers of all clients, same as mctpw_process_one().
+ * Not available in threaded mode.
+ */
+int mctpw_dispatch(void* client_context);
+
+/**
+ * @brief Switch library to threaded mode. Event loop is run by a library
+ * thread and client callbacks are invoked from pool of worker threads, API
+ * functions can be called from any thread including callbacks. Blocking calls
+ * wait only in calling thread, callbacks of other requests are delivered
+ * meanwhile.
+ * @param threads number of worker threads invoking client callbacks
+ * @note Callbacks of one client may be invoked concurrently when more than one
+ * worker thread is used. Payload passed to rx callback is a copy valid until
+ * callback returns.
+ * @return 0 if success or negative error code
+ */
+int mctpw_start_worker_threads(unsigned threads);
+
+/**
+ * @brief Stop threads started by mctpw_start_worker_threads() and return to
+ * single threaded mode, where client dispatches handlers with mctpw_process()
+ * or mctpw_process_one().
+ * @note Must not be called from client callback.
+ */
+void mctpw_stop_worker_threads(void);
+
 #ifdef __cplusplus
 }
 #endif
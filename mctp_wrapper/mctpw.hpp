@@ -0,0 +1,367 @@
+/*
+// Copyright (c) 2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/**
+ * @file mctpw.hpp
+ * @brief Header only C++ layer over MCTP wrapper async API. Operations follow
+ * Boost.Asio completion token model, the same call can be awaited from
+ * stackful coroutine (boost::asio::yield_context), C++20 coroutine
+ * (boost::asio::use_awaitable) or completed with plain callback. Operation
+ * state is passed to the library as callback user context, no std::function
+ * is allocated per call.
+ * @note Completion handler is invoked by its associated executor, not by the
+ * thread dispatching mctpw handlers.
+ * @note Operations must complete before client is unregistered.
+ */
+
+#ifndef MCTPW_HPP
+#define MCTPW_HPP
+
+#include "mctpw.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/version.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if BOOST_VERSION >= 107700
+#include <boost/asio/associated_cancellation_slot.hpp>
+#endif
+
+namespace mctpw
+{
+
+/** @brief Completion signature of asyncSend() */
+using SendSignature = void(boost::system::error_code);
+/** @brief Completion signature of asyncSendReceive() */
+using SendReceiveSignature = void(boost::system::error_code,
+                                  std::vector<uint8_t>);
+
+namespace detail
+{
+
+/** @brief Library status is negative errno */
+inline boost::system::error_code toErrorCode(int status)
+{
+    return boost::system::error_code(std::abs(status),
+                                     boost::system::system_category());
+}
+
+/**
+ * @brief State of one operation, shared by library callback and completion
+ * side. Library callback always fires once the request was accepted, it
+ * keeps a reference so that request buffer outlives cancelled operation.
+ * Completion is claimed by whichever comes first: library callback or
+ * cancellation.
+ */
+template <typename Handler, typename... Results>
+class Operation
+{
+  public:
+    Operation(Handler&& h, boost::asio::const_buffer requestBuffer) :
+        handler(std::move(h)),
+        work(boost::asio::get_associated_executor(handler)),
+        request(static_cast<const uint8_t*>(requestBuffer.data()),
+                static_cast<const uint8_t*>(requestBuffer.data()) +
+                    requestBuffer.size())
+    {
+    }
+
+    Operation(const Operation&) = delete;
+    Operation& operator=(const Operation&) = delete;
+
+    uint8_t* requestData()
+    {
+        return request.data();
+    }
+
+    unsigned requestSize() const
+    {
+        return static_cast<unsigned>(request.size());
+    }
+
+    /** @brief Returns true only for first caller */
+    bool claim()
+    {
+        return !done.exchange(true);
+    }
+
+    /** @brief Pass results to handler executor, must follow successful
+     * claim() */
+    void complete(Results... r)
+    {
+        results = std::make_tuple(std::move(r)...);
+        post();
+    }
+
+    /** @brief Same as complete() with error code and default results */
+    void completeWithError(boost::system::error_code ec)
+    {
+        std::get<0>(results) = ec;
+        post();
+    }
+
+    void release()
+    {
+        if (--refs == 0)
+        {
+            delete this;
+        }
+    }
+
+    /** @brief Complete operation that was not accepted by the library,
+     * library callback will not be invoked */
+    void fail(boost::system::error_code ec)
+    {
+        claim();
+        completeWithError(ec);
+        release();
+    }
+
+    /** @brief Connect per-operation cancellation, operation completes with
+     * boost::asio::error::operation_aborted and library request is left to
+     * finish in background */
+    void connectCancellation()
+    {
+#if BOOST_VERSION >= 107700
+        slot = boost::asio::get_associated_cancellation_slot(handler);
+        if (slot.is_connected())
+        {
+            slot.assign([this](boost::asio::cancellation_type) {
+                if (claim())
+                {
+                    completeWithError(boost::asio::error::operation_aborted);
+                }
+            });
+        }
+#endif
+    }
+
+  private:
+    void post()
+    {
+        auto executor = work.get_executor();
+        boost::asio::post(executor, [this]() {
+            Handler h(std::move(handler));
+            std::tuple<Results...> args(std::move(results));
+            work.reset();
+#if BOOST_VERSION >= 107700
+            if (slot.is_connected())
+            {
+                slot.clear();
+            }
+#endif
+            release();
+            std::apply(h, std::move(args));
+        });
+    }
+
+    ~Operation() = default;
+
+    Handler handler;
+    boost::asio::executor_work_guard<
+        boost::asio::associated_executor_t<Handler>>
+        work;
+    std::vector<uint8_t> request;
+    std::tuple<Results...> results;
+    std::atomic<bool> done{false};
+    /** @brief Library callback and completion side */
+    std::atomic<unsigned> refs{2};
+#if BOOST_VERSION >= 107700
+    boost::asio::associated_cancellation_slot_t<Handler> slot;
+#endif
+};
+
+template <typename Handler>
+using SendOperation = Operation<Handler, boost::system::error_code>;
+
+template <typename Handler>
+using SendReceiveOperation =
+    Operation<Handler, boost::system::error_code, std::vector<uint8_t>>;
+
+template <typename Handler>
+void onSendStatus(int ec, const void* userCtx)
+{
+    auto op = const_cast<SendOperation<Handler>*>(
+        static_cast<const SendOperation<Handler>*>(userCtx));
+    if (op->claim())
+    {
+        op->complete(ec ? toErrorCode(ec) : boost::system::error_code());
+    }
+    op->release();
+}
+
+template <typename Handler>
+void onSendReceiveStatus(int ec, const void* userCtx, uint8_t* response,
+                         unsigned responseLength)
+{
+    auto op = const_cast<SendReceiveOperation<Handler>*>(
+        static_cast<const SendReceiveOperation<Handler>*>(userCtx));
+    if (op->claim())
+    {
+        if (ec || !response)
+        {
+            op->completeWithError(toErrorCode(ec ? ec : -EIO));
+        }
+        else
+        {
+            op->complete(boost::system::error_code(),
+                         std::vector<uint8_t>(response,
+                                              response + responseLength));
+        }
+    }
+    op->release();
+}
+
+struct InitiateSend
+{
+    template <typename Handler>
+    void operator()(Handler&& handler, void* clientContext, mctpw_eid_t dstEid,
+                    bool tagOwner, uint8_t tag,
+                    boost::asio::const_buffer payload) const
+    {
+        auto op = new SendOperation<std::decay_t<Handler>>(
+            std::forward<Handler>(handler), payload);
+        if (op->requestSize() == 0)
+        {
+            op->fail(boost::asio::error::invalid_argument);
+            return;
+        }
+        op->connectCancellation();
+        int rc = mctpw_async_send_message(
+            clientContext, dstEid, tagOwner, tag, op->requestData(),
+            op->requestSize(), op, &onSendStatus<std::decay_t<Handler>>);
+        if (rc < 0)
+        {
+            op->fail(toErrorCode(rc));
+        }
+    }
+};
+
+struct InitiateSendReceive
+{
+    template <typename Handler>
+    void operator()(Handler&& handler, void* clientContext, mctpw_eid_t dstEid,
+                    boost::asio::const_buffer request,
+                    std::chrono::milliseconds timeout) const
+    {
+        auto op = new SendReceiveOperation<std::decay_t<Handler>>(
+            std::forward<Handler>(handler), request);
+        if (op->requestSize() == 0)
+        {
+            op->fail(boost::asio::error::invalid_argument);
+            return;
+        }
+        if (timeout.count() <= 0)
+        {
+            op->fail(boost::asio::error::timed_out);
+            return;
+        }
+        op->connectCancellation();
+        // mctpd takes 16 bit timeout in ms
+        auto timeoutMs = std::min<std::chrono::milliseconds::rep>(
+            timeout.count(), std::numeric_limits<uint16_t>::max());
+        int rc = mctpw_async_send_receive_atomic_message(
+            clientContext, dstEid, op->requestData(), op->requestSize(),
+            static_cast<unsigned>(timeoutMs), op,
+            &onSendReceiveStatus<std::decay_t<Handler>>);
+        if (rc < 0)
+        {
+            op->fail(toErrorCode(rc));
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Send MCTP payload, awaitable version of mctpw_async_send_message().
+ * @param clientContext pointer to client context
+ * @param dstEid destination endpoint eid
+ * @param tagOwner true for request, false for reply message
+ * @param tag numeric tag in range 0..7
+ * @param payload payload buffer, copied before function returns
+ * @param token completion token, completion signature is SendSignature
+ * @note Cancellation through associated cancellation slot is supported with
+ * Boost 1.77 or newer.
+ */
+template <typename CompletionToken>
+auto asyncSend(void* clientContext, mctpw_eid_t dstEid, bool tagOwner,
+               uint8_t tag, boost::asio::const_buffer payload,
+               CompletionToken&& token)
+{
+    return boost::asio::async_initiate<CompletionToken, SendSignature>(
+        detail::InitiateSend{}, token, clientContext, dstEid, tagOwner, tag,
+        payload);
+}
+
+/**
+ * @brief Send MCTP request and receive response, awaitable version of
+ * mctpw_async_send_receive_atomic_message().
+ * @param clientContext pointer to client context
+ * @param dstEid destination endpoint eid
+ * @param request request payload, copied before function returns
+ * @param timeout response timeout, limited to 65535 ms
+ * @param token completion token, completion signature is SendReceiveSignature
+ * @note Cancellation through associated cancellation slot is supported with
+ * Boost 1.77 or newer. Cancelled request is still completed by mctpd, its
+ * response is dropped.
+ */
+template <typename CompletionToken>
+auto asyncSendReceive(void* clientContext, mctpw_eid_t dstEid,
+                      boost::asio::const_buffer request,
+                      std::chrono::milliseconds timeout,
+                      CompletionToken&& token)
+{
+    return boost::asio::async_initiate<CompletionToken, SendReceiveSignature>(
+        detail::InitiateSendReceive{}, token, clientContext, dstEid, request,
+        timeout);
+}
+
+/**
+ * @brief Same as asyncSendReceive() with absolute deadline. Operation
+ * completes with boost::asio::error::timed_out when deadline has already
+ * passed.
+ */
+template <typename CompletionToken>
+auto asyncSendReceive(void* clientContext, mctpw_eid_t dstEid,
+                      boost::asio::const_buffer request,
+                      std::chrono::steady_clock::time_point deadline,
+                      CompletionToken&& token)
+{
+    return asyncSendReceive(
+        clientContext, dstEid, request,
+        std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()),
+        std::forward<CompletionToken>(token));
+}
+
+} // namespace mctpw
+
+#endif // MCTPW_HPP
@@ -26,6 +26,11 @@ using mctp_msg_types =
 
 class SMBusBinding;
 class PCIeBinding;
+class MctpBridge;
+
+constexpr uint8_t vendorIdNoMoreSets = 0xff;
+// Largest message libmctp reassembles, longer ones are dropped
+constexpr uint32_t mctpMaxMessageSize = 64 * 1024;
 
 struct SMBusConfiguration
 {
@@ -88,6 +93,34 @@ struct MctpVersionSupportCtrlResp
     std::vector<std::vector<uint8_t>> verNoEntry;
 };
 
+/*
+ * Capabilities reported by an endpoint, kept so that they can be served to
+ * clients without any bus traffic. Message types and UUID come from
+ * discovery, versions and VDM support are fetched on first use.
+ */
+struct EndpointCapabilities
+{
+    std::vector<uint8_t> msgTypes;
+    // <Message type, version entries as sent on the wire (major first)>,
+    // empty list marks a message type the endpoint has no versions for
+    std::unordered_map<uint8_t, std::vector<uint32_t>> versions;
+    std::vector<uint8_t> uuid;
+    // Vendor ID format, vendor ID data and command set type of each set
+    std::optional<std::vector<std::vector<uint8_t>>> vdmSupport;
+    // Distinguishes entries replaced while their background fetch waits
+    uint32_t generation = 0;
+};
+
+// Counters of inbound MCTP control requests
+struct CtrlReqStats
+{
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    uint64_t discoveryNotify = 0;
+    uint64_t discoveryNotifyCoalesced = 0;
+    uint64_t rediscoveries = 0;
+};
+
 enum class PacketState : uint8_t
 {
     invalidPacket,
@@ -117,17 +150,29 @@ class MctpTransmissionQueue
         std::vector<uint8_t> privateData{};
         boost::asio::steady_timer timer;
         std::optional<std::vector<uint8_t>> response{};
+        bool idempotent{false};
+        // Set when this message waits for the response of an identical
+        // request which is already in flight
+        std::weak_ptr<Message> leader{};
+        std::vector<std::shared_ptr<Message>> followers{};
     };
 
+    /*
+     * Idempotent messages that are identical to a message already queued or
+     * transmitted to the same EID (ignoring instance ID) are not sent again,
+     * they get a copy of the response of the original request instead.
+     */
     std::shared_ptr<Message> transmit(struct mctp* mctp, mctp_eid_t destEid,
                                       std::vector<uint8_t>&& payload,
                                       std::vector<uint8_t>&& privateData,
-                                      boost::asio::io_context& ioc);
+                                      boost::asio::io_context& ioc,
+                                      bool idempotent = false);
 
     bool receive(struct mctp* mctp, mctp_eid_t srcEid, uint8_t msgTag,
                  std::vector<uint8_t>&& response, boost::asio::io_context& ioc);
 
-    void dispose(mctp_eid_t destEid, const std::shared_ptr<Message>& message);
+    void dispose(struct mctp* mctp, mctp_eid_t destEid,
+                 const std::shared_ptr<Message>& message);
 
   private:
     struct Tags
@@ -147,6 +192,9 @@ class MctpTransmissionQueue
 
         size_t msgCounter{0u};
         void transmitQueuedMessages(struct mctp* mctp, mctp_eid_t destEid);
+        std::shared_ptr<Message>
+            findInFlight(const std::vector<uint8_t>& payload) const;
+        void promoteFollower(const std::shared_ptr<Message>& message);
     };
 
     std::map<mctp_eid_t, Endpoint> endpoints{};
@@ -165,6 +213,9 @@ class MctpBinding
 
     void handleCtrlReq(uint8_t destEid, void* bindingPrivate, const void* req,
                        size_t len, uint8_t msgTag);
+    void attachBridge(MctpBridge* mctpBridge);
+    void setConnection(
+        const std::shared_ptr<sdbusplus::asio::connection>& busConnection);
 
   protected:
     unsigned int ctrlTxRetryDelay;
@@ -208,6 +259,19 @@ class MctpBinding
                                      void* bindingPrivate,
                                      std::vector<uint8_t>& request,
                                      std::vector<uint8_t>& response);
+    virtual bool handleDiscoveryNotify(mctp_eid_t destEid,
+                                       void* bindingPrivate,
+                                       std::vector<uint8_t>& request,
+                                       std::vector<uint8_t>& response);
+    virtual void
+        rediscoverEndpoints(const std::set<mctp_eid_t>& eids,
+                            const std::set<std::vector<uint8_t>>& addresses);
+    virtual bool handleGetRoutingTable(mctp_eid_t destEid,
+                                       void* bindingPrivate,
+                                       std::vector<uint8_t>& request,
+                                       std::vector<uint8_t>& response);
+    virtual std::vector<uint8_t> getPhysicalAddress(mctp_eid_t eid);
+    virtual std::vector<uint8_t> getSourceAddress(const void* bindingPrivate);
     bool getEidCtrlCmd(boost::asio::yield_context& yield,
                        const std::vector<uint8_t>& bindingPrivate,
                        const mctp_eid_t destEid, std::vector<uint8_t>& resp);
@@ -228,6 +292,10 @@ class MctpBinding
         const std::vector<uint8_t>& bindingPrivate, const mctp_eid_t destEid,
         uint8_t msgTypeNo,
         MctpVersionSupportCtrlResp* mctpVersionSupportCtrlResp);
+    bool getVdmSupportCtrlCmd(boost::asio::yield_context& yield,
+                              const std::vector<uint8_t>& bindingPrivate,
+                              const mctp_eid_t destEid, uint8_t setSelector,
+                              std::vector<uint8_t>& resp);
     bool discoveryNotifyCtrlCmd(boost::asio::yield_context& yield,
                                 const std::vector<uint8_t>& bindingPrivate,
                                 const mctp_eid_t destEid);
@@ -265,6 +333,11 @@ class MctpBinding
     bool setMediumId(uint8_t value,
                      mctp_server::MctpPhysicalMediumIdentifiers& mediumId);
 
+#ifdef USE_MOCK
+    friend class MctpdBenchmark;
+    friend class MctpdTest;
+#endif
+
   private:
     bool staticEid;
     std::vector<uint8_t> uuid;
@@ -274,9 +347,26 @@ class MctpBinding
     std::vector<std::shared_ptr<dbus_interface>> msgTypeInterface;
     std::vector<std::shared_ptr<dbus_interface>> uuidInterface;
     boost::asio::steady_timer ctrlTxTimer;
+    MctpBridge* bridge = nullptr;
+    // Connection used for signals, differs per binding when bridging
+    std::shared_ptr<sdbusplus::asio::connection> connection;
+    boost::asio::steady_timer rediscoveryTimer;
+    bool rediscoveryPending = false;
+    // Endpoints which sent Discovery Notify since the last rediscovery, by
+    // EID if they had capabilities cached and by physical address
+    std::set<mctp_eid_t> rediscoveryEids;
+    std::set<std::vector<uint8_t>> rediscoveryAddresses;
+    CtrlReqStats ctrlReqStats;
+    // <Physical address (source EID if unknown), <window start, requests in
+    // window>>
+    std::map<std::vector<uint8_t>,
+             std::pair<std::chrono::steady_clock::time_point, unsigned int>>
+        ctrlReqRate;
 
     // map<EID, assigned>
     std::unordered_map<mctp_eid_t, bool> eidPoolMap;
+    std::unordered_map<mctp_eid_t, EndpointCapabilities> capabilityCache;
+    uint32_t capabilityGeneration = 0;
     bool ctrlTxTimerExpired = true;
     // <state, retryCount, maxRespDelay, destEid, BindingPrivate, ReqPacket,
     //  Callback>
@@ -292,7 +382,17 @@ class MctpBinding
     bool sendMctpMessage(mctp_eid_t destEid, std::vector<uint8_t> req,
                          bool tagOwner, uint8_t msgTag,
                          std::vector<uint8_t> bindingPrivate);
+    std::vector<uint8_t>
+        sendReceiveMctpMessage(boost::asio::yield_context yield,
+                               uint8_t dstEid, std::vector<uint8_t> payload,
+                               uint16_t timeout, bool idempotent);
     void processCtrlTxQueue();
+    bool isCtrlReqAllowed(const mctp_eid_t srcEid, const void* bindingPrivate);
+    MctpBinding* getBridgedBinding(const mctp_eid_t dstEid);
+    MctpBinding& getResponseBinding(const mctp_eid_t srcEid,
+                                    const uint8_t msgTag);
+    void scheduleRediscovery();
+    void runRediscovery();
     void pushToCtrlTxQueue(
         PacketState pktState, const mctp_eid_t destEid,
         const std::vector<uint8_t>& bindingPrivate,
@@ -310,7 +410,20 @@ class MctpBinding
                                  const std::vector<uint8_t>& bindingPrivate);
     void registerMsgTypes(std::shared_ptr<dbus_interface>& msgTypeIntf,
                           const MsgTypes& messageType);
-    void populateEndpointProperties(const EndpointProperties& epProperties);
+    bool populateEndpointProperties(const EndpointProperties& epProperties);
+    void updateCapabilityCache(const mctp_eid_t eid,
+                               const std::vector<uint8_t>& msgTypes,
+                               const std::vector<uint8_t>& epUuid);
+    void refreshCapabilities(boost::asio::yield_context& yield,
+                             const mctp_eid_t eid);
+    void fetchCapabilities(boost::asio::yield_context& yield,
+                           const mctp_eid_t eid);
+    void startCapabilityFetch(const mctp_eid_t eid);
+    EndpointCapabilities& getCachedCapabilities(const mctp_eid_t eid);
+    std::vector<uint32_t> getCachedVersions(const mctp_eid_t eid,
+                                            const uint8_t msgType);
+    std::vector<std::vector<uint8_t>>
+        getCachedVdmSupport(const mctp_eid_t eid);
     mctp_server::BindingModeTypes getEndpointType(const uint8_t types);
     MsgTypes getMsgTypes(const std::vector<uint8_t>& msgType);
     std::vector<uint8_t> getBindingMsgTypes();
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <libmctp.h>
+
+#include <map>
+#include <utility>
+
+class MctpBinding;
+
+/*
+ * Hosts several bindings in one mctpd process and keeps a routing table
+ * shared between them, so that a message to an EID reachable through any
+ * of the bridged networks is sent without going through a D-Bus client.
+ * Bridged networks share one EID space, an EID is routed to one binding
+ * only. Responses are handed to the binding whose client sent the request,
+ * whichever network they arrive from.
+ */
+class MctpBridge
+{
+  public:
+    void addBinding(MctpBinding* binding);
+    bool reserveEid(mctp_eid_t eid, MctpBinding* binding);
+    bool isEidAvailable(mctp_eid_t eid, const MctpBinding* binding) const;
+    bool addRoute(mctp_eid_t eid, MctpBinding* binding);
+    void removeRoute(mctp_eid_t eid, const MctpBinding* binding);
+    MctpBinding* getRoute(mctp_eid_t eid) const;
+    const std::map<mctp_eid_t, MctpBinding*>& getRoutingTable() const;
+    void addRequester(mctp_eid_t eid, uint8_t msgTag, MctpBinding* binding);
+    MctpBinding* takeRequester(mctp_eid_t eid, uint8_t msgTag);
+
+  private:
+    std::map<mctp_eid_t, MctpBinding*> routingTable;
+    // <EID, binding which has it in its EID pool>
+    std::map<mctp_eid_t, MctpBinding*> reservedEids;
+    // <<destination EID, tag>, binding which sent the request>
+    std::map<std::pair<mctp_eid_t, uint8_t>, MctpBinding*> requesters;
+};
@@ -9,8 +9,6 @@
 #include <boost/asio/deadline_timer.hpp>
 #include <xyz/openbmc_project/MCTP/Binding/PCIe/server.hpp>
 
-constexpr uint8_t vendorIdNoMoreSets = 0xff;
-
 struct InternalVdmSetDatabase
 {
     uint8_t idFormat;
@@ -56,6 +54,14 @@ class PCIeBinding : public MctpBinding
                                      void* bindingPrivate,
                                      std::vector<uint8_t>& request,
                                      std::vector<uint8_t>& response) override;
+    virtual std::vector<uint8_t> getPhysicalAddress(mctp_eid_t eid) override;
+    virtual std::vector<uint8_t>
+        getSourceAddress(const void* bindingPrivate) override;
+
+#ifdef USE_MOCK
+    friend class MctpdBenchmark;
+    friend class MctpdTest;
+#endif
 
   private:
     using routingTableEntry_t =
@@ -63,9 +69,9 @@ class PCIeBinding : public MctpBinding
     uint16_t bdf;
     uint16_t busOwnerBdf;
     std::shared_ptr<dbus_interface> pcieInterface;
-    udev* udevContext;
-    udev_device* udevice;
-    udev_monitor* umonitor;
+    udev* udevContext = nullptr;
+    udev_device* udevice = nullptr;
+    udev_monitor* umonitor = nullptr;
     static constexpr const char* astUdevPath =
         "/sys/devices/platform/ahb/e0800000.vdma";
     pcie_binding::DiscoveryFlags discoveredFlag{};
@@ -4,6 +4,7 @@
 
 #include <libmctp-smbus.h>
 
+#include <deque>
 #include <iostream>
 
 class SMBusBinding : public MctpBinding
@@ -21,10 +22,27 @@ class SMBusBinding : public MctpBinding
                                      std::vector<uint8_t>& request,
                                      std::vector<uint8_t>& response) override;
 
+  protected:
+    virtual void rediscoverEndpoints(
+        const std::set<mctp_eid_t>& eids,
+        const std::set<std::vector<uint8_t>>& addresses) override;
+    virtual std::vector<uint8_t> getPhysicalAddress(mctp_eid_t eid) override;
+    virtual std::vector<uint8_t>
+        getSourceAddress(const void* bindingPrivate) override;
+
+#ifdef USE_MOCK
+    friend class MctpdBenchmark;
+    friend class MctpdTest;
+#endif
+
   private:
     void SMBusInit();
     void readResponse();
     void initEndpointDiscovery();
+    void queueRegistration(const int fd, const uint8_t addr);
+    void registerDevice(boost::asio::yield_context& yield, const int fd,
+                        const uint8_t addr);
+    void rediscoverDevice(const int fd, const uint8_t slaveAddr);
     std::string bus;
     bool arpMasterSupport;
     uint8_t bmcSlaveAddr;
@@ -36,6 +54,11 @@ class SMBusBinding : public MctpBinding
     bool isMuxFd(const int fd);
     std::vector<std::pair<mctp_eid_t, struct mctp_smbus_extra_params>>
         smbusDeviceTable;
+    // <fd, 7 bit address> of devices waiting for registration, discovery
+    // and rediscovery share one coroutine registering them in order
+    std::deque<std::pair<int, uint8_t>> registrationQueue;
+    bool registrationRunning = false;
     void scanAllPorts(void);
-    void scanPort(const int scanFd);
+    void scanPort(const int scanFd, const uint8_t startAddr = 0x03,
+                  const uint8_t endAddr = 0x77);
 };
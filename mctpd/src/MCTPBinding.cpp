@@ -1,5 +1,6 @@
 #include "MCTPBinding.hpp"
 
+#include "MCTPBridge.hpp"
 #include "PCIeBinding.hpp"
 #include "SMBusBinding.hpp"
 
@@ -14,8 +15,17 @@
 constexpr sd_id128_t mctpdAppId = SD_ID128_MAKE(c4, e4, d9, 4a, 88, 43, 4d, f0,
                                                 94, 9d, bb, 0a, af, 53, 4e, 6d);
 constexpr unsigned int ctrlTxPollInterval = 5;
+// Inbound control requests accepted from one source EID per window
+constexpr unsigned int ctrlReqRateLimit = 16;
+constexpr auto ctrlReqRateWindow = std::chrono::seconds(1);
+// Discovery Notify requests within this window cause a single rediscovery
+constexpr auto rediscoveryHoldOff = std::chrono::seconds(2);
+// Keep Get Routing Table Entries responses within the baseline MTU
+constexpr size_t routingTableRespMaxSize = 64;
 constexpr size_t minCmdRespSize = 4;
 constexpr int completionCodeIndex = 3;
+constexpr size_t pldmInstanceIdIndex = 1;
+constexpr uint8_t pldmInstanceIdMask = 0x1F;
 
 const std::unordered_map<uint8_t, version_entry> versionNumbers = {
     {MCTP_MESSAGE_TYPE_MCTP_CTRL, {0xF1, 0xF3, 0xF1, 0}},
@@ -97,11 +107,89 @@ static const std::unordered_map<uint8_t,
                               /*0x41:0xFF Reserved*/
 };
 
+static uint8_t
+    getMediumIdValue(const mctp_server::MctpPhysicalMediumIdentifiers mediumId)
+{
+    auto mediumIter = std::find_if(
+        valueToMediumId.begin(), valueToMediumId.end(),
+        [mediumId](const auto& entry) { return entry.second == mediumId; });
+    if (mediumIter == valueToMediumId.end())
+    {
+        // Unspecified
+        return 0x00;
+    }
+    return mediumIter->first;
+}
+
 static uint8_t getInstanceId(const uint8_t msg)
 {
     return msg & MCTP_CTRL_HDR_INSTANCE_ID_MASK;
 }
 
+static bool hasPldmInstanceId(const std::vector<uint8_t>& payload)
+{
+    return payload.size() > pldmInstanceIdIndex &&
+           payload[0] == MCTP_MESSAGE_TYPE_PLDM;
+}
+
+/*
+ * Two requests are identical if they differ only in the instance ID, since
+ * every requester allocates its own.
+ */
+static bool isSameRequest(const std::vector<uint8_t>& lhs,
+                          const std::vector<uint8_t>& rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    if (!hasPldmInstanceId(lhs))
+    {
+        return lhs == rhs;
+    }
+    return std::equal(lhs.begin(), lhs.begin() + pldmInstanceIdIndex,
+                      rhs.begin()) &&
+           (lhs[pldmInstanceIdIndex] & ~pldmInstanceIdMask) ==
+               (rhs[pldmInstanceIdIndex] & ~pldmInstanceIdMask) &&
+           std::equal(lhs.begin() + pldmInstanceIdIndex + 1, lhs.end(),
+                      rhs.begin() + pldmInstanceIdIndex + 1);
+}
+
+/*
+ * A shared response carries the instance ID of the request that went on the
+ * bus, restore the one the waiting requester expects.
+ */
+static void setResponseInstanceId(std::vector<uint8_t>& response,
+                                  const std::vector<uint8_t>& request)
+{
+    if (!hasPldmInstanceId(response) || !hasPldmInstanceId(request))
+    {
+        return;
+    }
+    response[pldmInstanceIdIndex] = static_cast<uint8_t>(
+        (response[pldmInstanceIdIndex] & ~pldmInstanceIdMask) |
+        (request[pldmInstanceIdIndex] & pldmInstanceIdMask));
+}
+
+/*
+ * D-Bus match rules can filter only on string arguments, so message type and
+ * PCI vendor ID are also sent as strings to let the broker route messages.
+ */
+static std::string getVendorIdMatchKey(const std::vector<uint8_t>& payload)
+{
+    constexpr size_t vendorIdIndex = 1;
+    char vendorId[5];
+
+    if (payload[0] != MCTP_MESSAGE_TYPE_VDPCI ||
+        payload.size() < vendorIdIndex + sizeof(uint16_t))
+    {
+        return {};
+    }
+    snprintf(vendorId, sizeof(vendorId), "%02x%02x", payload[vendorIdIndex],
+             payload[vendorIdIndex + 1]);
+    return vendorId;
+}
+
 MctpTransmissionQueue::Message::Message(size_t index_,
                                         std::vector<uint8_t>&& payload_,
                                         std::vector<uint8_t>&& privateData_,
@@ -133,17 +221,83 @@ void MctpTransmissionQueue::Tags::erase(uint8_t flag)
 
 std::shared_ptr<MctpTransmissionQueue::Message> MctpTransmissionQueue::transmit(
     struct mctp* mctp, mctp_eid_t destEid, std::vector<uint8_t>&& payload,
-    std::vector<uint8_t>&& privateData, boost::asio::io_context& ioc)
+    std::vector<uint8_t>&& privateData, boost::asio::io_context& ioc,
+    bool idempotent)
 {
     auto& endpoint = endpoints[destEid];
     auto msgIndex = endpoint.msgCounter++;
     auto message = std::make_shared<Message>(msgIndex, std::move(payload),
                                              std::move(privateData), ioc);
+    message->idempotent = idempotent;
+    if (idempotent)
+    {
+        if (auto leader = endpoint.findInFlight(message->payload))
+        {
+            message->leader = leader;
+            leader->followers.emplace_back(message);
+            return message;
+        }
+    }
     endpoint.queuedMessages.emplace(msgIndex, message);
     endpoint.transmitQueuedMessages(mctp, destEid);
     return message;
 }
 
+std::shared_ptr<MctpTransmissionQueue::Message>
+    MctpTransmissionQueue::Endpoint::findInFlight(
+        const std::vector<uint8_t>& payload) const
+{
+    auto isIdentical = [&payload](const auto& entry) {
+        const auto& message = entry.second;
+        return message->idempotent && isSameRequest(message->payload, payload);
+    };
+
+    auto transmittedIter =
+        std::find_if(transmittedMessages.begin(), transmittedMessages.end(),
+                     isIdentical);
+    if (transmittedIter != transmittedMessages.end())
+    {
+        return transmittedIter->second;
+    }
+    auto queuedIter = std::find_if(queuedMessages.begin(),
+                                   queuedMessages.end(), isIdentical);
+    if (queuedIter != queuedMessages.end())
+    {
+        return queuedIter->second;
+    }
+    return nullptr;
+}
+
+/*
+ * The first follower takes over the place of a disposed message, so the
+ * remaining waiters still get the response of the request in flight.
+ */
+void MctpTransmissionQueue::Endpoint::promoteFollower(
+    const std::shared_ptr<Message>& message)
+{
+    auto successor = message->followers.front();
+    successor->leader.reset();
+    successor->followers.assign(message->followers.begin() + 1,
+                                message->followers.end());
+    message->followers.clear();
+    for (const auto& follower : successor->followers)
+    {
+        follower->leader = successor;
+    }
+
+    if (message->tag)
+    {
+        successor->tag = message->tag;
+        message->tag.reset();
+        transmittedMessages[successor->tag.value()] = successor;
+    }
+    else
+    {
+        successor->index = message->index;
+        queuedMessages[successor->index] = successor;
+    }
+}
+
 void MctpTransmissionQueue::Endpoint::transmitQueuedMessages(struct mctp* mctp,
                                                              mctp_eid_t destEid)
 {
@@ -194,6 +348,15 @@ bool MctpTransmissionQueue::receive(struct mctp* mctp, mctp_eid_t srcEid,
     }
 
     const auto message = messageIter->second;
+    for (const auto& follower : message->followers)
+    {
+        follower->response = response;
+        setResponseInstanceId(follower->response.value(), follower->payload);
+        follower->leader.reset();
+        follower->timer.cancel();
+    }
+    message->followers.clear();
+    setResponseInstanceId(response, message->payload);
     message->response = std::move(response);
     endpoint.transmittedMessages.erase(messageIter);
     message->tag.reset();
@@ -207,10 +370,25 @@ bool MctpTransmissionQueue::receive(struct mctp* mctp, mctp_eid_t srcEid,
     return true;
 }
 
-void MctpTransmissionQueue::dispose(mctp_eid_t destEid,
+void MctpTransmissionQueue::dispose(struct mctp* mctp, mctp_eid_t destEid,
                                     const std::shared_ptr<Message>& message)
 {
+    if (auto leader = message->leader.lock())
+    {
+        auto& followers = leader->followers;
+        followers.erase(
+            std::remove(followers.begin(), followers.end(), message),
+            followers.end());
+        message->leader.reset();
+        return;
+    }
+
     auto& endpoint = endpoints[destEid];
+    if (!message->followers.empty())
+    {
+        endpoint.promoteFollower(message);
+        return;
+    }
     auto queuedMessageIter = endpoint.queuedMessages.find(message->index);
     if (queuedMessageIter != endpoint.queuedMessages.end())
     {
@@ -226,6 +404,10 @@ void MctpTransmissionQueue::dispose(mctp_eid_t destEid,
         {
             endpoint.transmittedMessages.erase(transmittedMessageIter);
         }
+        message->tag.reset();
+
+        // Freed tag lets the next queued message go out
+        endpoint.transmitQueuedMessages(mctp, destEid);
     }
 }
 
@@ -298,11 +480,25 @@ void MctpBinding::rxMessage(uint8_t srcEid, void* data, void* msg, size_t len,
             return;
         }
 
-        auto msgSignal =
-            conn->new_signal("/xyz/openbmc_project/mctp",
-                             mctp_server::interface, "MessageReceivedSignal");
+        // Clients listen on the service they sent the request through
+        auto& receiver =
+            tagOwner ? binding : binding.getResponseBinding(srcEid, msgTag);
+
+#ifdef LEGACY_MESSAGE_SIGNAL
+        auto msgSignal = receiver.connection->new_signal(
+            "/xyz/openbmc_project/mctp", mctp_server::interface,
+            "MessageReceivedSignal");
         msgSignal.append(msgType, srcEid, msgTag, tagOwner, response);
         msgSignal.signal_send();
+#endif
+
+        auto filteredSignal = receiver.connection->new_signal(
+            "/xyz/openbmc_project/mctp", mctp_server::interface,
+            "FilteredMessageReceivedSignal");
+        filteredSignal.append(std::to_string(msgType),
+                              getVendorIdMatchKey(response), msgType, srcEid,
+                              msgTag, tagOwner, response);
+        filteredSignal.signal_send();
         return;
     }
 
@@ -357,7 +553,8 @@ MctpBinding::MctpBinding(std::shared_ptr<object_server>& objServer,
                          const std::string& objPath, ConfigurationVariant& conf,
                          boost::asio::io_context& ioc) :
     io(ioc),
-    objectServer(objServer), ctrlTxTimer(io)
+    objectServer(objServer), ctrlTxTimer(io), connection(conn),
+    rediscoveryTimer(io)
 {
     mctpInterface = objServer->add_interface(objPath, mctp_server::interface);
 
@@ -416,6 +613,8 @@ MctpBinding::MctpBinding(std::shared_ptr<object_server>& objServer,
             mctpInterface, "BindingMode",
             mctp_server::convertBindingModeTypesToString(bindingModeType));
 
+        registerProperty(mctpInterface, "MaxMessageSize", mctpMaxMessageSize);
+
         /*
          * msgTag and tagOwner are not currently used, but can't be removed
          * since they are defined for SendMctpMessagePayload() in the current
@@ -425,17 +624,33 @@ MctpBinding::MctpBinding(std::shared_ptr<object_server>& objServer,
             "SendMctpMessagePayload",
             [this](uint8_t dstEid, uint8_t msgTag, bool tagOwner,
                    std::vector<uint8_t> payload) {
+                MctpBinding* sender = this;
                 std::optional<std::vector<uint8_t>> pvtData =
                     getBindingPrivateData(dstEid);
-                if (pvtData)
+                if (!pvtData)
                 {
-                    return mctp_message_tx(mctp, dstEid, payload.data(),
-                                           payload.size(), tagOwner, msgTag,
-                                           pvtData->data());
+                    sender = getBridgedBinding(dstEid);
+                    if (sender != nullptr)
+                    {
+                        pvtData = sender->getBindingPrivateData(dstEid);
+                    }
                 }
-                phosphor::logging::log<phosphor::logging::level::ERR>(
-                    "Invalid destination EID");
-                return -1;
+                if (!pvtData)
+                {
+                    phosphor::logging::log<phosphor::logging::level::ERR>(
+                        "Invalid destination EID");
+                    return -1;
+                }
+                int rc = mctp_message_tx(sender->mctp, dstEid, payload.data(),
+                                         payload.size(), tagOwner, msgTag,
+                                         pvtData->data());
+                // Response comes in on the sender's network, it is signalled
+                // on this service
+                if (rc == 0 && tagOwner && bridge != nullptr)
+                {
+                    bridge->addRequester(dstEid, msgTag, this);
+                }
+                return rc;
             });
 
         mctpInterface->register_method(
@@ -443,62 +658,83 @@ MctpBinding::MctpBinding(std::shared_ptr<object_server>& objServer,
             [this](boost::asio::yield_context yield, uint8_t dstEid,
                    std::vector<uint8_t> payload,
                    uint16_t timeout) -> std::vector<uint8_t> {
-                uint8_t msgType = payload[0]; // Always the first byte
-                if (msgType == MCTP_MESSAGE_TYPE_MCTP_CTRL)
-                {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        "Cannot transmit control messages");
-                    throw std::system_error(
-                        std::make_error_code(std::errc::invalid_argument));
-                }
+                return sendReceiveMctpMessage(yield, dstEid, std::move(payload),
+                                              timeout, false);
+            });
 
-                std::optional<std::vector<uint8_t>> pvtData =
-                    getBindingPrivateData(dstEid);
-                if (!pvtData)
-                {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        "Invalid destination EID");
-                    throw std::system_error(
-                        std::make_error_code(std::errc::invalid_argument));
-                }
+        /*
+         * Same as SendReceiveMctpMessagePayload, for requests which can be
+         * answered with the response to an identical request in flight.
+         */
+        mctpInterface->register_method(
+            "SendReceiveIdempotentMctpMessagePayload",
+            [this](boost::asio::yield_context yield, uint8_t dstEid,
+                   std::vector<uint8_t> payload,
+                   uint16_t timeout) -> std::vector<uint8_t> {
+                return sendReceiveMctpMessage(yield, dstEid, std::move(payload),
+                                              timeout, true);
+            });
 
-                boost::system::error_code ec;
-                auto message =
-                    transmissionQueue.transmit(mctp, dstEid, std::move(payload),
-                                               std::move(pvtData).value(), io);
+        // Capabilities collected during discovery, versions and VDM support
+        // are fetched in the background right after it. All are answered
+        // from memory, EAGAIN until the background fetch got them.
+        mctpInterface->register_method(
+            "GetCachedMessageTypeSupport",
+            [this](uint8_t eid) -> std::vector<uint8_t> {
+                return getCachedCapabilities(eid).msgTypes;
+            });
 
-                message->timer.expires_after(
-                    std::chrono::milliseconds(timeout));
-                message->timer.async_wait(yield[ec]);
+        mctpInterface->register_method(
+            "GetCachedVersionSupport",
+            [this](uint8_t eid, uint8_t msgType) -> std::vector<uint32_t> {
+                return getCachedVersions(eid, msgType);
+            });
 
-                if (ec && ec != boost::asio::error::operation_aborted)
-                {
-                    transmissionQueue.dispose(dstEid, message);
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        "Timer failed");
-                    throw std::system_error(
-                        std::make_error_code(std::errc::connection_aborted));
-                }
-                if (!message->response)
-                {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        "No response");
-                    throw std::system_error(
-                        std::make_error_code(std::errc::timed_out));
-                }
-                if (message->response->empty())
+        mctpInterface->register_method(
+            "GetCachedUuid", [this](uint8_t eid) -> std::vector<uint8_t> {
+                const auto& epUuid = getCachedCapabilities(eid).uuid;
+                if (epUuid.empty())
                 {
-                    phosphor::logging::log<phosphor::logging::level::ERR>(
-                        "Empty response");
                     throw std::system_error(
                         std::make_error_code(std::errc::no_message_available));
                 }
-                return std::move(message->response).value();
+                return epUuid;
+            });
+
+        mctpInterface->register_method(
+            "GetCachedVdmSupport",
+            [this](uint8_t eid) -> std::vector<std::vector<uint8_t>> {
+                return getCachedVdmSupport(eid);
+            });
+
+        mctpInterface->register_method(
+            "GetControlRequestStatistics",
+            [this]() -> std::map<std::string, uint64_t> {
+                return {
+                    {"Received", ctrlReqStats.received},
+                    {"Dropped", ctrlReqStats.dropped},
+                    {"DiscoveryNotify", ctrlReqStats.discoveryNotify},
+                    {"DiscoveryNotifyCoalesced",
+                     ctrlReqStats.discoveryNotifyCoalesced},
+                    {"Rediscoveries", ctrlReqStats.rediscoveries}};
             });
 
+#ifdef LEGACY_MESSAGE_SIGNAL
+        // Wakes every listener for every message, kept for existing
+        // listeners. Built by default, LEGACY_MESSAGE_SIGNAL=OFF drops it
+        // where all listeners use FilteredMessageReceivedSignal.
         mctpInterface->register_signal<uint8_t, uint8_t, uint8_t, bool,
                                        std::vector<uint8_t>>(
             "MessageReceivedSignal");
+#endif
+
+        // Message type and VDPCI vendor ID strings usable in arg0/arg1 match
+        // rules, followed by message type, source EID, tag, tag owner and
+        // payload
+        mctpInterface->register_signal<std::string, std::string, uint8_t,
+                                       uint8_t, uint8_t, bool,
+                                       std::vector<uint8_t>>(
+            "FilteredMessageReceivedSignal");
 
         if (mctpInterface->initialize() == false)
         {
@@ -515,6 +751,66 @@ MctpBinding::MctpBinding(std::shared_ptr<object_server>& objServer,
     }
 }
 
+std::vector<uint8_t> MctpBinding::sendReceiveMctpMessage(
+    boost::asio::yield_context yield, uint8_t dstEid,
+    std::vector<uint8_t> payload, uint16_t timeout, bool idempotent)
+{
+    uint8_t msgType = payload[0]; // Always the first byte
+    if (msgType == MCTP_MESSAGE_TYPE_MCTP_CTRL)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Cannot transmit control messages");
+        throw std::system_error(
+            std::make_error_code(std::errc::invalid_argument));
+    }
+
+    std::optional<std::vector<uint8_t>> pvtData = getBindingPrivateData(dstEid);
+    if (!pvtData)
+    {
+        if (MctpBinding* peer = getBridgedBinding(dstEid))
+        {
+            return peer->sendReceiveMctpMessage(yield, dstEid,
+                                                std::move(payload), timeout,
+                                                idempotent);
+        }
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Invalid destination EID");
+        throw std::system_error(
+            std::make_error_code(std::errc::invalid_argument));
+    }
+
+    boost::system::error_code ec;
+    auto message =
+        transmissionQueue.transmit(mctp, dstEid, std::move(payload),
+                                   std::move(pvtData).value(), io, idempotent);
+
+    message->timer.expires_after(std::chrono::milliseconds(timeout));
+    message->timer.async_wait(yield[ec]);
+
+    if (ec && ec != boost::asio::error::operation_aborted)
+    {
+        transmissionQueue.dispose(mctp, dstEid, message);
+        phosphor::logging::log<phosphor::logging::level::ERR>("Timer failed");
+        throw std::system_error(
+            std::make_error_code(std::errc::connection_aborted));
+    }
+    if (!message->response)
+    {
+        // Hand the request over to coalesced requesters still waiting
+        transmissionQueue.dispose(mctp, dstEid, message);
+        phosphor::logging::log<phosphor::logging::level::ERR>("No response");
+        throw std::system_error(std::make_error_code(std::errc::timed_out));
+    }
+    if (message->response->empty())
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Empty response");
+        throw std::system_error(
+            std::make_error_code(std::errc::no_message_available));
+    }
+    return std::move(message->response).value();
+}
+
 MctpBinding::~MctpBinding()
 {
     objectServer->remove_interface(mctpInterface);
@@ -583,6 +879,11 @@ void MctpBinding::initializeEidPool(const std::set<mctp_eid_t>& pool)
 void MctpBinding::updateEidStatus(const mctp_eid_t endpointId,
                                   const bool assigned)
 {
+    if (!assigned)
+    {
+        capabilityCache.erase(endpointId);
+    }
+
     auto eidItr = eidPoolMap.find(endpointId);
     if (eidItr != eidPoolMap.end())
     {
@@ -615,7 +916,9 @@ mctp_eid_t MctpBinding::getAvailableEidFromPool()
 
     for (auto& eidPair : eidPoolMap)
     {
-        if (!eidPair.second)
+        // Static EID of an endpoint in a bridged network may be in the pool
+        if (!eidPair.second &&
+            (bridge == nullptr || bridge->isEidAvailable(eidPair.first, this)))
         {
             phosphor::logging::log<phosphor::logging::level::INFO>(
                 ("Allocated EID: " + std::to_string(eidPair.first)).c_str());
@@ -738,6 +1041,11 @@ void MctpBinding::handleCtrlReq(uint8_t destEid, void* bindingPrivate,
             "Binding Private Data is not correct.");
         return;
     }
+    // Drop floods before anything is allocated for them
+    if (!isCtrlReqAllowed(destEid, bindingPrivate))
+    {
+        return;
+    }
 
     std::vector<uint8_t> response = {};
     bool sendResponse = false;
@@ -786,6 +1094,16 @@ void MctpBinding::handleCtrlReq(uint8_t destEid, void* bindingPrivate,
                 handleGetVdmSupport(destEid, bindingPrivate, request, response);
             break;
         }
+        case MCTP_CTRL_CMD_GET_ROUTING_TABLE_ENTRIES: {
+            sendResponse = handleGetRoutingTable(destEid, bindingPrivate,
+                                                 request, response);
+            break;
+        }
+        case MCTP_CTRL_CMD_DISCOVERY_NOTIFY: {
+            sendResponse = handleDiscoveryNotify(destEid, bindingPrivate,
+                                                 request, response);
+            break;
+        }
         default: {
             phosphor::logging::log<phosphor::logging::level::ERR>(
                 "Message not supported");
@@ -919,6 +1237,256 @@ bool MctpBinding::handleGetVdmSupport(
     return false;
 }
 
+bool MctpBinding::handleDiscoveryNotify(mctp_eid_t destEid,
+                                        void* bindingPrivate,
+                                        std::vector<uint8_t>&,
+                                        std::vector<uint8_t>& response)
+{
+    // The endpoint may have changed, its capabilities have to be fetched
+    // again. Endpoint without EID has nothing cached yet.
+    if (destEid != MCTP_EID_NULL && capabilityCache.erase(destEid))
+    {
+        rediscoveryEids.insert(destEid);
+    }
+    auto address = getSourceAddress(bindingPrivate);
+    if (!address.empty())
+    {
+        rediscoveryAddresses.insert(std::move(address));
+    }
+    ctrlReqStats.discoveryNotify++;
+    scheduleRediscovery();
+
+    response.resize(sizeof(mctp_ctrl_resp_discovery_notify));
+    auto resp =
+        reinterpret_cast<mctp_ctrl_resp_discovery_notify*>(response.data());
+    resp->completion_code = MCTP_CTRL_CC_SUCCESS;
+    return true;
+}
+
+void MctpBinding::attachBridge(MctpBridge* mctpBridge)
+{
+    bridge = mctpBridge;
+
+    // EID pools of bridged networks must not overlap, EID shared with a
+    // binding attached earlier stays with that one
+    for (auto eidIter = eidPoolMap.begin(); eidIter != eidPoolMap.end();)
+    {
+        if (bridge->reserveEid(eidIter->first, this))
+        {
+            ++eidIter;
+            continue;
+        }
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "EID pool overlaps another bridged network, EID dropped",
+            phosphor::logging::entry("EID=%d", eidIter->first));
+        eidIter = eidPoolMap.erase(eidIter);
+    }
+}
+
+void MctpBinding::setConnection(
+    const std::shared_ptr<sdbusplus::asio::connection>& busConnection)
+{
+    connection = busConnection;
+}
+
+MctpBinding* MctpBinding::getBridgedBinding(const mctp_eid_t dstEid)
+{
+    if (bridge == nullptr)
+    {
+        return nullptr;
+    }
+    MctpBinding* peer = bridge->getRoute(dstEid);
+    if (peer == this)
+    {
+        return nullptr;
+    }
+    return peer;
+}
+
+MctpBinding& MctpBinding::getResponseBinding(const mctp_eid_t srcEid,
+                                             const uint8_t msgTag)
+{
+    if (bridge == nullptr)
+    {
+        return *this;
+    }
+    MctpBinding* requester = bridge->takeRequester(srcEid, msgTag);
+    if (requester == nullptr)
+    {
+        return *this;
+    }
+    return *requester;
+}
+
+std::vector<uint8_t>
+    MctpBinding::getSourceAddress(const void* /*bindingPrivate*/)
+{
+    return {};
+}
+
+std::vector<uint8_t> MctpBinding::getPhysicalAddress(mctp_eid_t /*eid*/)
+{
+    return {};
+}
+
+/*
+ * Reports every endpoint known to the bridge, one entry per EID. Entries
+ * are split over several responses using the entry handle as an index,
+ * the bridge routes less than 255 EIDs so 0xFF is never a valid index.
+ */
+bool MctpBinding::handleGetRoutingTable(mctp_eid_t, void*,
+                                        std::vector<uint8_t>& request,
+                                        std::vector<uint8_t>& response)
+{
+    if (bridge == nullptr)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Message not supported");
+        return false;
+    }
+
+    const auto& routingTable = bridge->getRoutingTable();
+    auto req =
+        reinterpret_cast<mctp_ctrl_cmd_get_routing_table*>(request.data());
+    if (request.size() < sizeof(mctp_ctrl_cmd_get_routing_table) ||
+        (req->entry_handle >= routingTable.size() && !routingTable.empty()))
+    {
+        response.resize(sizeof(mctp_ctrl_msg_hdr) + 1);
+        response.back() = MCTP_CTRL_CC_ERROR_INVALID_DATA;
+        return true;
+    }
+
+    size_t entryHandle = req->entry_handle;
+    response.resize(sizeof(mctp_ctrl_resp_get_routing_table));
+
+    uint8_t entryCount = 0;
+    auto routeIter = routingTable.begin();
+    std::advance(routeIter, std::min(entryHandle, routingTable.size()));
+    for (; routeIter != routingTable.end(); routeIter++, entryHandle++)
+    {
+        const auto& [eid, owner] = *routeIter;
+        std::vector<uint8_t> physAddress = owner->getPhysicalAddress(eid);
+        if (response.size() + sizeof(get_routing_table_entry) +
+                physAddress.size() >
+            routingTableRespMaxSize)
+        {
+            break;
+        }
+
+        get_routing_table_entry entry = {};
+        entry.eid_range_size = 1;
+        entry.starting_eid = eid;
+        entry.entry_type = MCTP_ROUTING_ENTRY_ENDPOINT;
+        entry.phys_transport_binding_id =
+            owner->bindingID == mctp_server::BindingTypes::MctpOverSmbus
+                ? MCTP_BINDING_SMBUS
+                : MCTP_BINDING_PCIE;
+        entry.phys_media_type_id = getMediumIdValue(owner->bindingMediumID);
+        entry.phys_address_size = static_cast<uint8_t>(physAddress.size());
+
+        auto entryPtr = reinterpret_cast<uint8_t*>(&entry);
+        response.insert(response.end(), entryPtr, entryPtr + sizeof(entry));
+        response.insert(response.end(), physAddress.begin(),
+                        physAddress.end());
+        entryCount++;
+    }
+
+    auto resp =
+        reinterpret_cast<mctp_ctrl_resp_get_routing_table*>(response.data());
+    resp->completion_code = MCTP_CTRL_CC_SUCCESS;
+    resp->number_of_entries = entryCount;
+    resp->next_entry_handle = routeIter == routingTable.end()
+                                  ? 0xFF
+                                  : static_cast<uint8_t>(entryHandle);
+    return true;
+}
+
+/*
+ * Bus is not scanned again, only the endpoints which sent Discovery Notify
+ * get their capabilities fetched again.
+ */
+void MctpBinding::rediscoverEndpoints(
+    const std::set<mctp_eid_t>& eids,
+    const std::set<std::vector<uint8_t>>& /*addresses*/)
+{
+    if (eids.empty())
+    {
+        return;
+    }
+    boost::asio::spawn(io, [this, eids](boost::asio::yield_context yield) {
+        for (const mctp_eid_t eid : eids)
+        {
+            refreshCapabilities(yield, eid);
+        }
+    });
+}
+
+bool MctpBinding::isCtrlReqAllowed(const mctp_eid_t srcEid,
+                                   const void* bindingPrivate)
+{
+    ctrlReqStats.received++;
+
+    // Endpoints without EID are told apart by their physical address
+    std::vector<uint8_t> key = getSourceAddress(bindingPrivate);
+    if (key.empty())
+    {
+        key.push_back(srcEid);
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto& [windowStart, count] = ctrlReqRate[key];
+    if (now - windowStart >= ctrlReqRateWindow)
+    {
+        windowStart = now;
+        count = 0;
+    }
+    if (count >= ctrlReqRateLimit)
+    {
+        ctrlReqStats.dropped++;
+        if (count++ == ctrlReqRateLimit)
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Control request rate limit exceeded, dropping requests",
+                phosphor::logging::entry("EID=%d", srcEid));
+        }
+        return false;
+    }
+    count++;
+    return true;
+}
+
+/*
+ * Rediscovery starts once the hold-off after the first Discovery Notify
+ * expires, notifications received meanwhile are folded into it.
+ */
+void MctpBinding::scheduleRediscovery()
+{
+    if (rediscoveryPending)
+    {
+        ctrlReqStats.discoveryNotifyCoalesced++;
+        return;
+    }
+    rediscoveryPending = true;
+    rediscoveryTimer.expires_after(rediscoveryHoldOff);
+    rediscoveryTimer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec)
+        {
+            return;
+        }
+        runRediscovery();
+    });
+}
+
+void MctpBinding::runRediscovery()
+{
+    rediscoveryPending = false;
+    ctrlReqStats.rediscoveries++;
+    std::set<mctp_eid_t> eids;
+    std::set<std::vector<uint8_t>> addresses;
+    eids.swap(rediscoveryEids);
+    addresses.swap(rediscoveryAddresses);
+    rediscoverEndpoints(eids, addresses);
+}
+
 void MctpBinding::pushToCtrlTxQueue(
     PacketState state, const mctp_eid_t destEid,
     const std::vector<uint8_t>& bindingPrivate, const std::vector<uint8_t>& req,
@@ -1363,6 +1931,45 @@ bool MctpBinding::getMctpVersionSupportCtrlCmd(
     return true;
 }
 
+bool MctpBinding::getVdmSupportCtrlCmd(
+    boost::asio::yield_context& yield,
+    const std::vector<uint8_t>& bindingPrivate, const mctp_eid_t destEid,
+    uint8_t setSelector, std::vector<uint8_t>& resp)
+{
+    std::vector<uint8_t> req = {};
+
+    if (!getFormattedReq<MCTP_CTRL_CMD_GET_VENDOR_MESSAGE_SUPPORT>(
+            req, setSelector))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Get VDM Support: Request formatting failed");
+        return false;
+    }
+
+    if (PacketState::receivedResponse !=
+        sendAndRcvMctpCtrl(yield, req, destEid, bindingPrivate, resp))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Get VDM Support: Unable to get response");
+        return false;
+    }
+
+    // Vendor ID data length depends on the vendor ID format
+    const size_t minVdmRespLen = 7;
+    if (resp.size() < minVdmRespLen ||
+        resp[completionCodeIndex] != MCTP_CTRL_CC_SUCCESS)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Get VDM Support: Invalid response",
+            phosphor::logging::entry("LEN=%d", resp.size()));
+        return false;
+    }
+
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "Get VDM Support success");
+    return true;
+}
+
 bool MctpBinding::discoveryNotifyCtrlCmd(
     boost::asio::yield_context& yield,
     const std::vector<uint8_t>& bindingPrivate, const mctp_eid_t destEid)
@@ -1454,9 +2061,14 @@ void MctpBinding::registerMsgTypes(std::shared_ptr<dbus_interface>& msgTypeIntf,
     msgTypeIntf->initialize();
 }
 
-void MctpBinding::populateEndpointProperties(
+bool MctpBinding::populateEndpointProperties(
     const EndpointProperties& epProperties)
 {
+    // Endpoint is not exposed if its EID is used in another bridged network
+    if (bridge && !bridge->addRoute(epProperties.endpointEid, this))
+    {
+        return false;
+    }
 
     std::string mctpDevObj = "/xyz/openbmc_project/mctp/device/";
     std::shared_ptr<dbus_interface> endpointIntf;
@@ -1487,6 +2099,182 @@ void MctpBinding::populateEndpointProperties(
     uuidIntf->register_property("UUID", epProperties.uuid);
     uuidIntf->initialize();
     uuidInterface.push_back(uuidIntf);
+    return true;
+}
+
+void MctpBinding::updateCapabilityCache(const mctp_eid_t eid,
+                                        const std::vector<uint8_t>& msgTypes,
+                                        const std::vector<uint8_t>& epUuid)
+{
+    EndpointCapabilities capabilities;
+    capabilities.msgTypes = msgTypes;
+    capabilities.uuid = epUuid;
+    capabilities.generation = ++capabilityGeneration;
+    capabilityCache.insert_or_assign(eid, std::move(capabilities));
+}
+
+EndpointCapabilities& MctpBinding::getCachedCapabilities(const mctp_eid_t eid)
+{
+    auto capabilitiesIter = capabilityCache.find(eid);
+    if (capabilitiesIter == capabilityCache.end())
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "No cached capabilities",
+            phosphor::logging::entry("EID=%d", eid));
+        throw std::system_error(
+            std::make_error_code(std::errc::no_such_device_or_address));
+    }
+    return capabilitiesIter->second;
+}
+
+static std::vector<uint32_t>
+    getVersionEntries(const MctpVersionSupportCtrlResp& versionResp)
+{
+    std::vector<uint32_t> versions;
+    for (const auto& entry : versionResp.verNoEntry)
+    {
+        uint32_t version = 0;
+        for (const uint8_t byte : entry)
+        {
+            version = (version << 8) | byte;
+        }
+        versions.push_back(version);
+    }
+    return versions;
+}
+
+static bool isVdmSupported(const std::vector<uint8_t>& msgTypes)
+{
+    return std::find_if(msgTypes.begin(), msgTypes.end(),
+                        [](const uint8_t type) {
+                            return type == MCTP_MESSAGE_TYPE_VDPCI ||
+                                   type == MCTP_MESSAGE_TYPE_VDIANA;
+                        }) != msgTypes.end();
+}
+
+/*
+ * Versions of every supported message type and VDM support sets are fetched
+ * once the endpoint is registered, so that the Cached methods never wait for
+ * the bus. Error completion code is cached as an empty list, exchange
+ * without response leaves the entry missing until the endpoint is refreshed.
+ */
+void MctpBinding::fetchCapabilities(boost::asio::yield_context& yield,
+                                    const mctp_eid_t eid)
+{
+    auto bindingPrivate = getBindingPrivateData(eid);
+    auto capabilitiesIter = capabilityCache.find(eid);
+    if (!bindingPrivate || capabilitiesIter == capabilityCache.end())
+    {
+        return;
+    }
+    const uint32_t generation = capabilitiesIter->second.generation;
+    const std::vector<uint8_t> msgTypes = capabilitiesIter->second.msgTypes;
+    // Endpoint may have been removed or refreshed while waiting
+    auto current = [this, eid, generation]() -> EndpointCapabilities* {
+        auto iter = capabilityCache.find(eid);
+        if (iter == capabilityCache.end() ||
+            iter->second.generation != generation)
+        {
+            return nullptr;
+        }
+        return &iter->second;
+    };
+
+    for (const uint8_t msgType : msgTypes)
+    {
+        if (current()->versions.count(msgType) != 0)
+        {
+            continue;
+        }
+        MctpVersionSupportCtrlResp versionResp{};
+        versionResp.completionCode = MCTP_CTRL_CC_SUCCESS;
+        bool success = getMctpVersionSupportCtrlCmd(
+            yield, bindingPrivate.value(), eid, msgType, &versionResp);
+        EndpointCapabilities* capabilities = current();
+        if (!capabilities)
+        {
+            return;
+        }
+        if (success || versionResp.completionCode != MCTP_CTRL_CC_SUCCESS)
+        {
+            capabilities->versions.insert_or_assign(
+                msgType, getVersionEntries(versionResp));
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> vdmSupport;
+    if (isVdmSupported(msgTypes))
+    {
+        const size_t vendorIdFormatIndex = 5;
+        uint8_t setSelector = 0;
+        while (true)
+        {
+            std::vector<uint8_t> resp;
+            if (!getVdmSupportCtrlCmd(yield, bindingPrivate.value(), eid,
+                                      setSelector, resp))
+            {
+                // Sets listed before an error completion code are complete,
+                // partial list of an endpoint not responding is not cached
+                if (resp.size() > completionCodeIndex &&
+                    resp[completionCodeIndex] != MCTP_CTRL_CC_SUCCESS)
+                {
+                    break;
+                }
+                return;
+            }
+            vdmSupport.emplace_back(resp.begin() + vendorIdFormatIndex,
+                                    resp.end());
+            uint8_t nextSelector = resp[vendorIdFormatIndex - 1];
+            if (nextSelector == vendorIdNoMoreSets ||
+                nextSelector <= setSelector)
+            {
+                break;
+            }
+            setSelector = nextSelector;
+        }
+    }
+    if (EndpointCapabilities* capabilities = current())
+    {
+        capabilities->vdmSupport = std::move(vdmSupport);
+    }
+}
+
+void MctpBinding::startCapabilityFetch(const mctp_eid_t eid)
+{
+    boost::asio::spawn(io, [this, eid](boost::asio::yield_context yield) {
+        fetchCapabilities(yield, eid);
+    });
+}
+
+// Capabilities not fetched yet are reported as temporarily unavailable
+std::vector<uint32_t> MctpBinding::getCachedVersions(const mctp_eid_t eid,
+                                                     const uint8_t msgType)
+{
+    const auto& cachedVersions = getCachedCapabilities(eid).versions;
+    auto versionIter = cachedVersions.find(msgType);
+    if (versionIter == cachedVersions.end())
+    {
+        throw std::system_error(std::make_error_code(
+            std::errc::resource_unavailable_try_again));
+    }
+    if (versionIter->second.empty())
+    {
+        throw std::system_error(
+            std::make_error_code(std::errc::no_message_available));
+    }
+    return versionIter->second;
+}
+
+std::vector<std::vector<uint8_t>>
+    MctpBinding::getCachedVdmSupport(const mctp_eid_t eid)
+{
+    const auto& vdmSupport = getCachedCapabilities(eid).vdmSupport;
+    if (!vdmSupport)
+    {
+        throw std::system_error(std::make_error_code(
+            std::errc::resource_unavailable_try_again));
+    }
+    return vdmSupport.value();
 }
 
 mctp_server::BindingModeTypes MctpBinding::getEndpointType(const uint8_t types)
@@ -1593,6 +2381,17 @@ static std::string formatUUID(guid_t& uuid)
     return std::string(buf);
 }
 
+static std::vector<uint8_t> getUuidRaw(const std::vector<uint8_t>& getUuidResp)
+{
+    if (getUuidResp.size() != sizeof(mctp_ctrl_resp_get_uuid))
+    {
+        return {};
+    }
+    return std::vector<uint8_t>(
+        getUuidResp.begin() + offsetof(mctp_ctrl_resp_get_uuid, uuid),
+        getUuidResp.end());
+}
+
 std::optional<mctp_eid_t> MctpBinding::busOwnerRegisterEndpoint(
     boost::asio::yield_context& yield,
     const std::vector<uint8_t>& bindingPrivate)
@@ -1706,7 +2505,16 @@ std::optional<mctp_eid_t> MctpBinding::busOwnerRegisterEndpoint(
     // Keep Network ID as zero and update it later if a change happend.
     epProperties.networkId = 0x00;
     epProperties.endpointMsgTypes = getMsgTypes(msgTypeSupportResp.msgType);
-    populateEndpointProperties(epProperties);
+    if (!populateEndpointProperties(epProperties))
+    {
+        return std::nullopt;
+    }
+    updateCapabilityCache(destEid, msgTypeSupportResp.msgType,
+                          getUuidRaw(getUuidResp));
+    // Control version was already fetched for the registration itself
+    capabilityCache[destEid].versions[MCTP_MESSAGE_TYPE_MCTP_CTRL] =
+        getVersionEntries(getMctpControlVersion);
+    startCapabilityFetch(destEid);
 
     return destEid;
 }
@@ -1757,10 +2565,52 @@ std::optional<mctp_eid_t>
     // TODO:get Network ID, now set it to 0
     epProperties.networkId = 0x00;
     epProperties.endpointMsgTypes = getMsgTypes(msgTypeSupportResp.msgType);
-    populateEndpointProperties(epProperties);
+    if (!populateEndpointProperties(epProperties))
+    {
+        return std::nullopt;
+    }
+    updateCapabilityCache(eid, msgTypeSupportResp.msgType,
+                          getUuidRaw(getUuidResp));
+    startCapabilityFetch(eid);
     return eid;
 }
 
+// Fetches what discovery caches for an endpoint which is already registered
+void MctpBinding::refreshCapabilities(boost::asio::yield_context& yield,
+                                      const mctp_eid_t eid)
+{
+    auto bindingPrivate = getBindingPrivateData(eid);
+    if (!bindingPrivate)
+    {
+        return;
+    }
+
+    MsgTypeSupportCtrlResp msgTypeSupportResp;
+    if (!(getMsgTypeSupportCtrlCmd(yield, bindingPrivate.value(), eid,
+                                   &msgTypeSupportResp)))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Get Message Type Support failed",
+            phosphor::logging::entry("EID=%d", eid));
+        return;
+    }
+
+    std::vector<uint8_t> getUuidResp;
+    if (!(getUuidCtrlCmd(yield, bindingPrivate.value(), eid, getUuidResp)))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Get UUID failed");
+    }
+    // Endpoint may have been removed while waiting for the responses
+    if (!getBindingPrivateData(eid))
+    {
+        return;
+    }
+    updateCapabilityCache(eid, msgTypeSupportResp.msgType,
+                          getUuidRaw(getUuidResp));
+    fetchCapabilities(yield, eid);
+}
+
 void MctpBinding::removeInterface(
     std::string& interfacePath,
     std::vector<std::shared_ptr<dbus_interface>>& interfaces)
@@ -1786,4 +2636,9 @@ void MctpBinding::unregisterEndpoint(mctp_eid_t eid)
     removeInterface(mctpEpObj, endpointInterface);
     removeInterface(mctpEpObj, msgTypeInterface);
     removeInterface(mctpEpObj, uuidInterface);
+    capabilityCache.erase(eid);
+    if (bridge)
+    {
+        bridge->removeRoute(eid, this);
+    }
 }
@@ -0,0 +1,96 @@
+#include "MCTPBridge.hpp"
+
+#include "MCTPBinding.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+void MctpBridge::addBinding(MctpBinding* binding)
+{
+    binding->attachBridge(this);
+}
+
+bool MctpBridge::reserveEid(mctp_eid_t eid, MctpBinding* binding)
+{
+    auto [reservedIter, inserted] = reservedEids.emplace(eid, binding);
+    return inserted || reservedIter->second == binding;
+}
+
+bool MctpBridge::isEidAvailable(mctp_eid_t eid,
+                                const MctpBinding* binding) const
+{
+    MctpBinding* owner = getRoute(eid);
+    if (owner != nullptr && owner != binding)
+    {
+        return false;
+    }
+    auto reservedIter = reservedEids.find(eid);
+    return reservedIter == reservedEids.end() ||
+           reservedIter->second == binding;
+}
+
+/*
+ * NULL and broadcast EIDs are never routed, which keeps the table below 255
+ * entries, so entry handle 0xFF always means the end of the table.
+ */
+bool MctpBridge::addRoute(mctp_eid_t eid, MctpBinding* binding)
+{
+    if (eid == MCTP_EID_NULL || eid == MCTP_EID_BROADCAST)
+    {
+        return false;
+    }
+    if (!isEidAvailable(eid, binding))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "EID already used in another bridged network",
+            phosphor::logging::entry("EID=%d", eid));
+        return false;
+    }
+    routingTable[eid] = binding;
+    return true;
+}
+
+void MctpBridge::removeRoute(mctp_eid_t eid, const MctpBinding* binding)
+{
+    auto routeIter = routingTable.find(eid);
+    if (routeIter != routingTable.end() && routeIter->second == binding)
+    {
+        routingTable.erase(routeIter);
+    }
+}
+
+MctpBinding* MctpBridge::getRoute(mctp_eid_t eid) const
+{
+    auto routeIter = routingTable.find(eid);
+    if (routeIter == routingTable.end())
+    {
+        return nullptr;
+    }
+    return routeIter->second;
+}
+
+const std::map<mctp_eid_t, MctpBinding*>& MctpBridge::getRoutingTable() const
+{
+    return routingTable;
+}
+
+/*
+ * Tag is owned by the last request sent to the EID with it, an older entry
+ * is overwritten.
+ */
+void MctpBridge::addRequester(mctp_eid_t eid, uint8_t msgTag,
+                              MctpBinding* binding)
+{
+    requesters[std::make_pair(eid, msgTag)] = binding;
+}
+
+MctpBinding* MctpBridge::takeRequester(mctp_eid_t eid, uint8_t msgTag)
+{
+    auto requesterIter = requesters.find(std::make_pair(eid, msgTag));
+    if (requesterIter == requesters.end())
+    {
+        return nullptr;
+    }
+    MctpBinding* binding = requesterIter->second;
+    requesters.erase(requesterIter);
+    return binding;
+}
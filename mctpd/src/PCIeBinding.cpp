@@ -642,6 +642,37 @@ std::optional<std::vector<uint8_t>>
     return std::vector<uint8_t>(pktPrvPtr, pktPrvPtr + sizeof(pktPrv));
 }
 
+std::vector<uint8_t> PCIeBinding::getPhysicalAddress(mctp_eid_t eid)
+{
+    auto it = find_if(routingTable.begin(), routingTable.end(),
+                      [&eid](const auto& entry) {
+                          const auto& [entryEid, endpointBdf, entryType] =
+                              entry;
+                          return entryEid == eid;
+                      });
+    if (it == routingTable.end())
+    {
+        return {};
+    }
+    // BDF is sent most significant byte first
+    const uint16_t endpointBdf = std::get<1>(*it);
+    return {static_cast<uint8_t>(endpointBdf >> 8),
+            static_cast<uint8_t>(endpointBdf & 0xFF)};
+}
+
+std::vector<uint8_t> PCIeBinding::getSourceAddress(const void* bindingPrivate)
+{
+    if (!isReceivedPrivateDataCorrect(bindingPrivate))
+    {
+        return {};
+    }
+    const uint16_t sourceBdf =
+        reinterpret_cast<const mctp_nupcie_pkt_private*>(bindingPrivate)
+            ->remote_id;
+    return {static_cast<uint8_t>(sourceBdf >> 8),
+            static_cast<uint8_t>(sourceBdf & 0xFF)};
+}
+
 void PCIeBinding::changeDiscoveredFlag(pcie_binding::DiscoveryFlags flag)
 {
     discoveredFlag = flag;
@@ -10,6 +10,7 @@ extern "C" {
 }
 
 #include <boost/algorithm/string.hpp>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <phosphor-logging/log.hpp>
@@ -31,11 +32,9 @@ static void throwRunTimeError(const std::string& err)
     throw std::runtime_error(err);
 }
 
-void SMBusBinding::scanPort(const int scanFd)
+void SMBusBinding::scanPort(const int scanFd, const uint8_t startAddr,
+                            const uint8_t endAddr)
 {
-    constexpr uint8_t startAddr = 0x03;
-    constexpr uint8_t endAddr = 0x77;
-
     if (scanFd < 0)
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
@@ -431,52 +430,185 @@ void SMBusBinding::initEndpointDiscovery()
     /* Scan bus once */
     scanAllPorts();
 
-    /* Since i2c muxes restrict that only one command needs to be
-     * in flight, we cannot register multiple endpoints in parallel.
-     * Thus, in a single yield_context, all the discovered devices
-     * are attempted with registration sequentially */
+    for (const auto& device : deviceMap)
+    {
+        queueRegistration(std::get<0>(device), std::get<1>(device));
+    }
+}
 
+/* Since i2c muxes restrict that only one command needs to be
+ * in flight, we cannot register multiple endpoints in parallel.
+ * Thus, in a single yield_context, all the queued devices
+ * are attempted with registration sequentially */
+void SMBusBinding::queueRegistration(const int fd, const uint8_t addr)
+{
+    auto device = std::make_pair(fd, addr);
+    if (std::find(registrationQueue.begin(), registrationQueue.end(),
+                  device) != registrationQueue.end())
+    {
+        return;
+    }
+    registrationQueue.push_back(device);
+    if (registrationRunning)
+    {
+        return;
+    }
+    registrationRunning = true;
     boost::asio::spawn(io, [this](boost::asio::yield_context yield) {
-        for (auto& device : deviceMap)
+        while (!registrationQueue.empty())
         {
-            phosphor::logging::log<phosphor::logging::level::INFO>(
-                ("Checking if device " + std::to_string(std::get<1>(device)) +
-                 " is MCTP Capable")
-                    .c_str());
+            auto [deviceFd, deviceAddr] = registrationQueue.front();
+            registrationQueue.pop_front();
+            registerDevice(yield, deviceFd, deviceAddr);
+        }
+        registrationRunning = false;
+    });
+}
 
-            struct mctp_smbus_extra_params smbusBindingPvt;
-            smbusBindingPvt.fd = std::get<0>(device);
+void SMBusBinding::registerDevice(boost::asio::yield_context& yield,
+                                  const int fd, const uint8_t addr)
+{
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        ("Checking if device " + std::to_string(addr) + " is MCTP Capable")
+            .c_str());
 
-            if (isMuxFd(smbusBindingPvt.fd))
-            {
-                smbusBindingPvt.muxHoldTimeOut = ctrlTxRetryDelay;
-                smbusBindingPvt.muxFlags = 0x80;
-            }
-            else
-            {
-                smbusBindingPvt.muxHoldTimeOut = 0;
-                smbusBindingPvt.muxFlags = 0;
-            }
-            /* Set 8 bit i2c slave address */
-            smbusBindingPvt.slave_addr =
-                static_cast<uint8_t>((std::get<1>(device) << 1));
-
-            auto const ptr = reinterpret_cast<uint8_t*>(&smbusBindingPvt);
-            std::vector<uint8_t> bindingPvtVect(ptr,
-                                                ptr + sizeof(smbusBindingPvt));
-            mctp_eid_t eid = 0xFF;
-            if( smbusBindingPvt.slave_addr == 0xE2)//This is a PLDM I2C Slave device on NCT6681 and NCT6692
-                eid = 0x08;
-
-            auto rc = registerEndpoint(yield, bindingPvtVect, eid);
-            if (rc)
-            {
-                fprintf(stderr,"push EID:%d slave_addr:%X in smbusDeviceTable\n", rc.value(), smbusBindingPvt.slave_addr);
-                smbusDeviceTable.push_back(
-                    std::make_pair(rc.value(), smbusBindingPvt));
-            }
+    struct mctp_smbus_extra_params smbusBindingPvt;
+    smbusBindingPvt.fd = fd;
+
+    if (isMuxFd(smbusBindingPvt.fd))
+    {
+        smbusBindingPvt.muxHoldTimeOut = ctrlTxRetryDelay;
+        smbusBindingPvt.muxFlags = 0x80;
+    }
+    else
+    {
+        smbusBindingPvt.muxHoldTimeOut = 0;
+        smbusBindingPvt.muxFlags = 0;
+    }
+    /* Set 8 bit i2c slave address */
+    smbusBindingPvt.slave_addr = static_cast<uint8_t>((addr << 1));
+
+    /* Device queued by discovery and rediscovery is registered once */
+    if (std::find_if(smbusDeviceTable.begin(), smbusDeviceTable.end(),
+                     [&smbusBindingPvt](const auto& entry) {
+                         return entry.second.fd == smbusBindingPvt.fd &&
+                                entry.second.slave_addr ==
+                                    smbusBindingPvt.slave_addr;
+                     }) != smbusDeviceTable.end())
+    {
+        return;
+    }
+
+    auto const ptr = reinterpret_cast<uint8_t*>(&smbusBindingPvt);
+    std::vector<uint8_t> bindingPvtVect(ptr, ptr + sizeof(smbusBindingPvt));
+    mctp_eid_t eid = 0xFF;
+    if( smbusBindingPvt.slave_addr == 0xE2)//This is a PLDM I2C Slave device on NCT6681 and NCT6692
+        eid = 0x08;
+
+    auto rc = registerEndpoint(yield, bindingPvtVect, eid);
+    if (!rc)
+    {
+        return;
+    }
+
+    /* EID is unique in the table, an entry left by a device which no
+     * longer owns it is stale */
+    smbusDeviceTable.erase(
+        std::remove_if(smbusDeviceTable.begin(), smbusDeviceTable.end(),
+                       [&rc](const auto& entry) {
+                           return entry.first == rc.value();
+                       }),
+        smbusDeviceTable.end());
+    fprintf(stderr,"push EID:%d slave_addr:%X in smbusDeviceTable\n", rc.value(), smbusBindingPvt.slave_addr);
+    smbusDeviceTable.push_back(std::make_pair(rc.value(), smbusBindingPvt));
+}
+
+void SMBusBinding::rediscoverEndpoints(
+    const std::set<mctp_eid_t>& eids,
+    const std::set<std::vector<uint8_t>>& addresses)
+{
+    if (bindingModeType != mctp_server::BindingModeTypes::BusOwner)
+    {
+        MctpBinding::rediscoverEndpoints(eids, addresses);
+        return;
+    }
+
+    // Source keys, see getSourceAddress
+    for (const auto& address : addresses)
+    {
+        if (address.size() == 1 + sizeof(int))
+        {
+            int fd;
+            std::memcpy(&fd, address.data() + 1, sizeof(fd));
+            rediscoverDevice(fd, address[0]);
         }
-    });
+    }
+}
+
+/* Only the device which sent Discovery Notify is registered again, it keeps
+ * its EID. Identical devices behind other mux channels share its address and
+ * are left alone. Device unknown so far is probed on its address and channel
+ * only, instead of scanning the whole bus. */
+void SMBusBinding::rediscoverDevice(const int fd, const uint8_t slaveAddr)
+{
+    const uint8_t addr = static_cast<uint8_t>(slaveAddr >> 1);
+    bool registered = false;
+    for (auto deviceIter = smbusDeviceTable.begin();
+         deviceIter != smbusDeviceTable.end();)
+    {
+        if (deviceIter->second.fd != fd ||
+            deviceIter->second.slave_addr != slaveAddr)
+        {
+            ++deviceIter;
+            continue;
+        }
+        unregisterEndpoint(deviceIter->first);
+        queueRegistration(deviceIter->second.fd, addr);
+        deviceIter = smbusDeviceTable.erase(deviceIter);
+        registered = true;
+    }
+    if (registered)
+    {
+        return;
+    }
+
+    scanPort(fd, addr, static_cast<uint8_t>(addr + 1));
+    for (const auto& device : deviceMap)
+    {
+        if (std::get<0>(device) == fd && std::get<1>(device) == addr)
+        {
+            queueRegistration(std::get<0>(device), addr);
+        }
+    }
+}
+
+std::vector<uint8_t> SMBusBinding::getPhysicalAddress(mctp_eid_t eid)
+{
+    auto deviceIter = std::find_if(
+        smbusDeviceTable.begin(), smbusDeviceTable.end(),
+        [eid](const auto& device) { return device.first == eid; });
+    if (deviceIter == smbusDeviceTable.end())
+    {
+        return {};
+    }
+    return {deviceIter->second.slave_addr};
+}
+
+std::vector<uint8_t> SMBusBinding::getSourceAddress(const void* bindingPrivate)
+{
+    if (bindingPrivate == nullptr)
+    {
+        return {};
+    }
+    auto smbusPrivate =
+        reinterpret_cast<const mctp_smbus_extra_params*>(bindingPrivate);
+    // Same 8 bit format as the device table, without the read/write bit,
+    // followed by the fd of the bus or mux channel the device sits on
+    std::vector<uint8_t> key = {
+        static_cast<uint8_t>(smbusPrivate->slave_addr & 0xFE)};
+    const auto fd = reinterpret_cast<const uint8_t*>(&smbusPrivate->fd);
+    key.insert(key.end(), fd, fd + sizeof(smbusPrivate->fd));
+    return key;
 }
 
 // TODO: This method is a placeholder and has not been tested
@@ -1,4 +1,5 @@
 #include "MCTPBinding.hpp"
+#include "MCTPBridge.hpp"
 #include "PCIeBinding.hpp"
 #include "SMBusBinding.hpp"
 
@@ -6,6 +7,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/asio/signal_set.hpp>
 #include <iostream>
+#include <list>
 #include <nlohmann/json.hpp>
 #include <phosphor-logging/log.hpp>
 #include <regex>
@@ -403,13 +405,19 @@ std::unique_ptr<MctpBinding>
 int main(int argc, char* argv[])
 {
     CLI::App app("MCTP Daemon");
-    std::string binding;
-    std::optional<std::pair<std::string, ConfigurationVariant>>
-        mctpdConfigurationPair;
-
-    app.add_option("-b,--binding", binding,
-                   "MCTP Physical Binding. Supported: -b smbus, -b pcie")
-        ->required();
+    std::vector<std::string> bindings;
+    // Lists, since bindings keep references to their object servers
+    std::list<std::pair<std::string, ConfigurationVariant>>
+        mctpdConfigurations;
+    std::list<std::shared_ptr<object_server>> objectServers;
+    std::vector<std::unique_ptr<MctpBinding>> bindingPtrs;
+    MctpBridge bridge;
+
+    app.add_option("-b,--binding", bindings,
+                   "MCTP Physical Binding. Supported: -b smbus, -b pcie. "
+                   "Multiple bindings are bridged: -b smbus,pcie")
+        ->required()
+        ->delimiter(',');
     app.add_option("-c,--config", configPath, "Path to configuration file.",
                    true);
     CLI11_PARSE(app, argc, argv);
@@ -422,35 +430,60 @@ int main(int argc, char* argv[])
     conn = std::make_shared<sdbusplus::asio::connection>(ioc);
 
     /* Process configuration */
-    try
+    for (const auto& binding : bindings)
     {
-        mctpdConfigurationPair = getConfiguration(binding);
-    }
-    catch (const std::exception& e)
-    {
-        phosphor::logging::log<phosphor::logging::level::WARNING>(
-            (std::string("Exception: ") + e.what()).c_str());
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "Invalid configuration; exiting");
-        return -1;
-    }
+        std::optional<std::pair<std::string, ConfigurationVariant>>
+            mctpdConfigurationPair;
+        try
+        {
+            mctpdConfigurationPair = getConfiguration(binding);
+        }
+        catch (const std::exception& e)
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                (std::string("Exception: ") + e.what()).c_str());
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Invalid configuration; exiting");
+            return -1;
+        }
 
-    if (!mctpdConfigurationPair)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "Could not load any configuration; exiting");
-        return -1;
+        if (!mctpdConfigurationPair)
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Could not load any configuration; exiting");
+            return -1;
+        }
+        mctpdConfigurations.push_back(std::move(*mctpdConfigurationPair));
+    }
+
+    /* Every binding owns a D-Bus service and object tree, the first one is
+     * hosted on the default connection */
+    for (auto& [mctpdName, mctpdConfiguration] : mctpdConfigurations)
+    {
+        auto bindingConn =
+            bindingPtrs.empty()
+                ? conn
+                : std::make_shared<sdbusplus::asio::connection>(ioc);
+        auto& objectServer = objectServers.emplace_back(
+            std::make_shared<object_server>(bindingConn));
+        const std::string mctpServiceName = "xyz.openbmc_project." + mctpdName;
+        bindingConn->request_name(mctpServiceName.c_str());
+
+        auto& bindingPtr = bindingPtrs.emplace_back(
+            getBindingPtr(mctpdConfiguration, objectServer, ioc));
+        bindingPtr->setConnection(bindingConn);
+        if (mctpdConfigurations.size() > 1)
+        {
+            bridge.addBinding(bindingPtr.get());
+        }
     }
 
-    auto& [mctpdName, mctpdConfiguration] = *mctpdConfigurationPair;
-    auto objectServer = std::make_shared<object_server>(conn);
-    const std::string mctpServiceName = "xyz.openbmc_project." + mctpdName;
-    conn->request_name(mctpServiceName.c_str());
-
-    auto bindingPtr = getBindingPtr(mctpdConfiguration, objectServer, ioc);
     try
     {
-        bindingPtr->initializeBinding();
+        for (auto& bindingPtr : bindingPtrs)
+        {
+            bindingPtr->initializeBinding();
+        }
     }
     catch (const std::exception& e)
     {
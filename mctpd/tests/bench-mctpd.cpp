@@ -0,0 +1,427 @@
+#include "PCIeBinding.hpp"
+#include "SMBusBinding.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "libmctp-msgtypes.h"
+
+std::shared_ptr<sdbusplus::asio::connection> conn;
+
+static const std::string mctpBaseObj = "/xyz/openbmc_project/mctp";
+constexpr mctp_eid_t benchOwnEid = 8;
+constexpr mctp_eid_t benchDestEid = 10;
+constexpr uint8_t benchTargetInstanceId = 0x1F;
+
+/*
+ * Binding which accepts every packet without touching hardware, so
+ * mctp_message_tx() exercises the libmctp packetization path only.
+ */
+static int nullBindingTx(struct mctp_binding*, struct mctp_pktbuf*)
+{
+    return 0;
+}
+
+/*
+ * Gives the benchmarks access to binding internals which are otherwise
+ * only reachable through hardware events.
+ */
+class MctpdBenchmark
+{
+  public:
+    using CtrlTxCallback =
+        std::function<void(PacketState, std::vector<uint8_t>&)>;
+
+    static struct mctp* initializeMctp(MctpBinding& binding)
+    {
+        binding.initializeMctp();
+        mctp_set_log_stdio(MCTP_LOG_ERR);
+        return binding.mctp;
+    }
+
+    static MctpTransmissionQueue& transmissionQueue(MctpBinding& binding)
+    {
+        return binding.transmissionQueue;
+    }
+
+    static void pushCtrlTx(MctpBinding& binding, uint8_t instanceId)
+    {
+        std::vector<uint8_t> req(sizeof(mctp_ctrl_msg_hdr));
+        mctp_ctrl_msg_hdr* hdr =
+            reinterpret_cast<mctp_ctrl_msg_hdr*>(req.data());
+        hdr->ic_msg_type = MCTP_MESSAGE_TYPE_MCTP_CTRL;
+        hdr->rq_dgram_inst = static_cast<uint8_t>(
+            MCTP_CTRL_HDR_FLAG_REQUEST |
+            (instanceId & MCTP_CTRL_HDR_INSTANCE_ID_MASK));
+        hdr->command_code = MCTP_CTRL_CMD_GET_ENDPOINT_ID;
+
+        binding.ctrlTxQueue.emplace_back(
+            PacketState::transmitted, binding.ctrlTxRetryCount,
+            binding.ctrlTxRetryDelay, benchDestEid, std::vector<uint8_t>(),
+            std::move(req),
+            CtrlTxCallback([](PacketState, std::vector<uint8_t>&) {}));
+    }
+
+    static void clearCtrlTxQueue(MctpBinding& binding)
+    {
+        binding.ctrlTxQueue.clear();
+    }
+
+    static void handleCtrlResp(MctpBinding& binding, std::vector<uint8_t>& resp)
+    {
+        binding.handleCtrlResp(resp.data(), resp.size());
+    }
+
+    static void rxMessage(MctpBinding& binding, mctp_eid_t srcEid,
+                          std::vector<uint8_t>& msg, bool tagOwner,
+                          uint8_t msgTag)
+    {
+        MctpBinding::rxMessage(srcEid, &binding, msg.data(), msg.size(),
+                               tagOwner, msgTag, nullptr);
+    }
+
+    static void fillDeviceTable(SMBusBinding& binding, size_t entries)
+    {
+        binding.smbusDeviceTable.clear();
+        for (size_t i = 0; i < entries; i++)
+        {
+            mctp_smbus_extra_params params = {};
+            params.fd = static_cast<int>(i);
+            params.slave_addr = static_cast<uint8_t>(0x10 + (i % 0x60));
+            binding.smbusDeviceTable.emplace_back(
+                static_cast<mctp_eid_t>(benchDestEid + i), params);
+        }
+    }
+
+    static void fillRoutingTable(PCIeBinding& binding, size_t entries)
+    {
+        binding.routingTable.clear();
+        for (size_t i = 0; i < entries; i++)
+        {
+            binding.routingTable.emplace_back(
+                static_cast<uint8_t>(benchDestEid + i),
+                static_cast<uint16_t>(0x0100 + i), 0);
+        }
+    }
+
+    static std::optional<std::vector<uint8_t>>
+        getBindingPrivateData(MctpBinding& binding, uint8_t dstEid)
+    {
+        return binding.getBindingPrivateData(dstEid);
+    }
+};
+
+class MctpdFixture : public benchmark::Fixture
+{
+  public:
+    void SetUp(const ::benchmark::State&) override
+    {
+        objectServerMock =
+            std::make_shared<mctpd_mock::object_server_mock>(mctpBaseObj);
+        objectServerMock->dbusIfMock->returnByDefault(true);
+
+        SMBusConfiguration smbusConfig{};
+        smbusConfig.mediumId =
+            mctp_server::MctpPhysicalMediumIdentifiers::SmbusI2c;
+        smbusConfig.mode = mctp_server::BindingModeTypes::Endpoint;
+        smbusConfig.defaultEid = benchOwnEid;
+        smbusConfig.reqToRespTime = 100;
+        smbusConfig.reqRetryCount = 2;
+        smbusConfiguration.emplace<SMBusConfiguration>(smbusConfig);
+
+        PcieConfiguration pcieConfig{};
+        pcieConfig.mediumId = mctp_server::MctpPhysicalMediumIdentifiers::Pcie3;
+        pcieConfig.mode = mctp_server::BindingModeTypes::BusOwner;
+        pcieConfig.defaultEid = benchOwnEid;
+        pcieConfig.reqToRespTime = 100;
+        pcieConfig.reqRetryCount = 2;
+        pcieConfig.getRoutingInterval = 5;
+        pcieConfiguration.emplace<PcieConfiguration>(pcieConfig);
+
+        std::string objPath = mctpBaseObj;
+        smbusBinding = std::make_unique<SMBusBinding>(
+            objectServerMock, objPath, smbusConfiguration, ioc);
+        pcieBinding = std::make_unique<PCIeBinding>(
+            objectServerMock, objPath, pcieConfiguration, ioc);
+
+        mctp = MctpdBenchmark::initializeMctp(*smbusBinding);
+        nullBinding = {};
+        nullBinding.name = "bench";
+        nullBinding.version = 1;
+        nullBinding.pkt_size = MCTP_PACKET_SIZE(MCTP_BTU);
+        nullBinding.tx = nullBindingTx;
+        mctp_register_bus(mctp, &nullBinding, benchOwnEid);
+        mctp_binding_set_tx_enabled(&nullBinding, true);
+    }
+
+    void TearDown(const ::benchmark::State&) override
+    {
+        pcieBinding.reset();
+        smbusBinding.reset();
+        objectServerMock.reset();
+    }
+
+    boost::asio::io_context ioc;
+    std::shared_ptr<mctpd_mock::object_server_mock> objectServerMock;
+    ConfigurationVariant smbusConfiguration;
+    ConfigurationVariant pcieConfiguration;
+    std::unique_ptr<SMBusBinding> smbusBinding;
+    std::unique_ptr<PCIeBinding> pcieBinding;
+    struct mctp* mctp = nullptr;
+    struct mctp_binding nullBinding;
+};
+
+static std::vector<uint8_t> makePayload(size_t size)
+{
+    std::vector<uint8_t> payload(size, 0xA5);
+    payload[0] = MCTP_MESSAGE_TYPE_PLDM;
+    return payload;
+}
+
+static std::vector<uint8_t> makeCtrlResp(uint8_t instanceId)
+{
+    std::vector<uint8_t> resp(sizeof(mctp_ctrl_resp_get_eid));
+    mctp_ctrl_msg_hdr* hdr = reinterpret_cast<mctp_ctrl_msg_hdr*>(resp.data());
+    hdr->ic_msg_type = MCTP_MESSAGE_TYPE_MCTP_CTRL;
+    hdr->rq_dgram_inst =
+        static_cast<uint8_t>(instanceId & MCTP_CTRL_HDR_INSTANCE_ID_MASK);
+    hdr->command_code = MCTP_CTRL_CMD_GET_ENDPOINT_ID;
+    return resp;
+}
+
+/*
+ * Queue a message, let it get a tag and transmit it, then drop it as if the
+ * requester timed out.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, TransmitDispose)(benchmark::State& state)
+{
+    auto& queue = MctpdBenchmark::transmissionQueue(*smbusBinding);
+    const size_t payloadSize = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto message = queue.transmit(mctp, benchDestEid,
+                                      makePayload(payloadSize), {}, ioc);
+        queue.dispose(mctp, benchDestEid, message);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(MctpdFixture, TransmitDispose)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(4096);
+
+/*
+ * Full request/response round trip through the transmission queue,
+ * including the deferred retransmission of queued messages.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, TransmitReceive)(benchmark::State& state)
+{
+    auto& queue = MctpdBenchmark::transmissionQueue(*smbusBinding);
+    const size_t payloadSize = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto message = queue.transmit(mctp, benchDestEid,
+                                      makePayload(payloadSize), {}, ioc);
+        if (!message->tag)
+        {
+            state.SkipWithError("No tag assigned");
+            break;
+        }
+        queue.receive(mctp, benchDestEid, message->tag.value(),
+                      makePayload(payloadSize), ioc);
+        ioc.poll();
+        ioc.restart();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 2);
+}
+BENCHMARK_REGISTER_F(MctpdFixture, TransmitReceive)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(1024);
+
+/*
+ * Several requesters sending the same idempotent request, all of them
+ * served by a single transaction on the bus.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, TransmitReceiveCoalesced)
+(benchmark::State& state)
+{
+    auto& queue = MctpdBenchmark::transmissionQueue(*smbusBinding);
+    const size_t requesters = static_cast<size_t>(state.range(0));
+    std::vector<std::shared_ptr<MctpTransmissionQueue::Message>> messages;
+
+    for (auto _ : state)
+    {
+        messages.clear();
+        for (size_t i = 0; i < requesters; i++)
+        {
+            auto payload = makePayload(16);
+            payload[1] = static_cast<uint8_t>(0x80 | (i & 0x1F));
+            messages.emplace_back(queue.transmit(
+                mctp, benchDestEid, std::move(payload), {}, ioc, true));
+        }
+        if (!messages.front()->tag)
+        {
+            state.SkipWithError("No tag assigned");
+            break;
+        }
+        queue.receive(mctp, benchDestEid, messages.front()->tag.value(),
+                      makePayload(16), ioc);
+        ioc.poll();
+        ioc.restart();
+    }
+}
+BENCHMARK_REGISTER_F(MctpdFixture, TransmitReceiveCoalesced)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(8);
+
+/*
+ * All tags are in use, so new messages land in the per-endpoint queue.
+ * Measures queueing and disposal of a pending message at a given depth.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, DisposeQueued)(benchmark::State& state)
+{
+    auto& queue = MctpdBenchmark::transmissionQueue(*smbusBinding);
+    std::vector<std::shared_ptr<MctpTransmissionQueue::Message>> pending;
+    const size_t depth = static_cast<size_t>(state.range(0)) + 8;
+
+    for (size_t i = 0; i < depth; i++)
+    {
+        pending.emplace_back(
+            queue.transmit(mctp, benchDestEid, makePayload(64), {}, ioc));
+    }
+
+    for (auto _ : state)
+    {
+        auto message =
+            queue.transmit(mctp, benchDestEid, makePayload(64), {}, ioc);
+        queue.dispose(mctp, benchDestEid, message);
+    }
+
+    for (const auto& message : pending)
+    {
+        queue.dispose(mctp, benchDestEid, message);
+    }
+}
+BENCHMARK_REGISTER_F(MctpdFixture, DisposeQueued)->RangeMultiplier(4)->Range(
+    1, 1024);
+
+/*
+ * Matching of a control response against outstanding control requests.
+ * The matching request is always the last one in the queue.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, HandleCtrlResp)(benchmark::State& state)
+{
+    const size_t depth = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> resp = makeCtrlResp(benchTargetInstanceId);
+
+    MctpdBenchmark::clearCtrlTxQueue(*smbusBinding);
+    for (size_t i = 0; i + 1 < depth; i++)
+    {
+        MctpdBenchmark::pushCtrlTx(
+            *smbusBinding,
+            static_cast<uint8_t>(i % MCTP_CTRL_HDR_INSTANCE_ID_MASK));
+    }
+
+    for (auto _ : state)
+    {
+        MctpdBenchmark::pushCtrlTx(*smbusBinding, benchTargetInstanceId);
+        MctpdBenchmark::handleCtrlResp(*smbusBinding, resp);
+    }
+    MctpdBenchmark::clearCtrlTxQueue(*smbusBinding);
+}
+BENCHMARK_REGISTER_F(MctpdFixture, HandleCtrlResp)->RangeMultiplier(2)->Range(
+    1, 64);
+
+/*
+ * Lookup of the destination EID in the SMBus device table, EID being the
+ * last entry.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, SmbusGetBindingPrivateData)
+(benchmark::State& state)
+{
+    const size_t entries = static_cast<size_t>(state.range(0));
+    const uint8_t lastEid = static_cast<uint8_t>(benchDestEid + entries - 1);
+
+    MctpdBenchmark::fillDeviceTable(*smbusBinding, entries);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            MctpdBenchmark::getBindingPrivateData(*smbusBinding, lastEid));
+    }
+}
+BENCHMARK_REGISTER_F(MctpdFixture, SmbusGetBindingPrivateData)
+    ->RangeMultiplier(4)
+    ->Range(1, 64);
+
+/*
+ * Lookup of the destination EID in the PCIe routing table, EID being the
+ * last entry.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, PcieGetBindingPrivateData)
+(benchmark::State& state)
+{
+    const size_t entries = static_cast<size_t>(state.range(0));
+    const uint8_t lastEid = static_cast<uint8_t>(benchDestEid + entries - 1);
+
+    MctpdBenchmark::fillRoutingTable(*pcieBinding, entries);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            MctpdBenchmark::getBindingPrivateData(*pcieBinding, lastEid));
+    }
+}
+BENCHMARK_REGISTER_F(MctpdFixture, PcieGetBindingPrivateData)
+    ->RangeMultiplier(4)
+    ->Range(1, 64);
+
+/*
+ * rxMessage dispatch of a response to a request sent with
+ * SendReceiveMctpMessagePayload.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, RxMessageResponse)(benchmark::State& state)
+{
+    auto& queue = MctpdBenchmark::transmissionQueue(*smbusBinding);
+    std::vector<uint8_t> resp =
+        makePayload(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto message =
+            queue.transmit(mctp, benchDestEid, makePayload(64), {}, ioc);
+        state.ResumeTiming();
+
+        MctpdBenchmark::rxMessage(*smbusBinding, benchDestEid, resp, false,
+                                  message->tag.value_or(0));
+
+        state.PauseTiming();
+        ioc.poll();
+        ioc.restart();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK_REGISTER_F(MctpdFixture, RxMessageResponse)->Arg(64)->Arg(1024);
+
+/*
+ * rxMessage dispatch of an MCTP control response.
+ */
+BENCHMARK_DEFINE_F(MctpdFixture, RxMessageCtrlResp)(benchmark::State& state)
+{
+    std::vector<uint8_t> resp = makeCtrlResp(benchTargetInstanceId);
+
+    MctpdBenchmark::clearCtrlTxQueue(*smbusBinding);
+    for (auto _ : state)
+    {
+        MctpdBenchmark::pushCtrlTx(*smbusBinding, benchTargetInstanceId);
+        MctpdBenchmark::rxMessage(*smbusBinding, benchDestEid, resp, false,
+                                  0);
+    }
+    MctpdBenchmark::clearCtrlTxQueue(*smbusBinding);
+}
+BENCHMARK_REGISTER_F(MctpdFixture, RxMessageCtrlResp);
+
+BENCHMARK_MAIN();
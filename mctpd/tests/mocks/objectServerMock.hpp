@@ -65,6 +65,13 @@ class dbus_interface_mock
         return register_method(name);
     }
 
+    template <typename PropertyType>
+    bool set_property(__attribute__((unused)) const std::string& name,
+                      __attribute__((unused)) const PropertyType& value)
+    {
+        return true;
+    }
+
     std::string get_object_path(void)
     {
         std::string object_path;
@@ -128,7 +135,8 @@ class object_server_mock
 
 // DBus interface with list of property types supported
 using dbus_interface_mock = MockType<impl::dbus_interface_mock<
-    bool, uint8_t, uint16_t, const std::string&, std::vector<uint8_t>>>;
+    bool, uint8_t, uint16_t, uint32_t, const std::string&,
+    std::vector<uint8_t>>>;
 
 using object_server_mock =
     MockType<impl::object_server_mock<dbus_interface_mock>>;
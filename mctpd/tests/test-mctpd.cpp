@@ -1,3 +1,4 @@
+#include "MCTPBridge.hpp"
 #include "PCIeBinding.hpp"
 #include "SMBusBinding.hpp"
 
@@ -27,7 +28,7 @@ class MctpdBaseTest : public ::testing::Test
         mctp_server::BindingModeTypes mode, uint8_t defaultEid,
         std::set<uint8_t> eidPool, std::string busName)
     {
-        SMBusConfiguration smbusConfig;
+        SMBusConfiguration smbusConfig{};
 
         smbusConfig.mediumId = mediumId;
         smbusConfig.mode = mode;
@@ -95,10 +96,23 @@ TEST_F(MctpdBaseTest, BaseIfPropertyTest)
         .Times(1)
         .WillRepeatedly(Return(true));
 
+    EXPECT_CALL(
+        *objectServerMock->dbusIfMock,
+        register_property(StrEq("MaxMessageSize"), An<uint32_t>(),
+                          Eq(sdbusplus::asio::PropertyPermission::readOnly)))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+#ifdef LEGACY_MESSAGE_SIGNAL
     EXPECT_CALL(*objectServerMock->dbusIfMock,
                 register_signal(StrEq("MessageReceivedSignal")))
         .Times(1)
         .WillRepeatedly(Return(true));
+#else
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_signal(StrEq("MessageReceivedSignal")))
+        .Times(0);
+#endif
 
     EXPECT_CALL(*objectServerMock->dbusIfMock,
                 register_method(StrEq("SendMctpMessagePayload")))
@@ -110,6 +124,42 @@ TEST_F(MctpdBaseTest, BaseIfPropertyTest)
         .Times(1)
         .WillRepeatedly(Return(true));
 
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_signal(StrEq("FilteredMessageReceivedSignal")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(
+        *objectServerMock->dbusIfMock,
+        register_method(StrEq("SendReceiveIdempotentMctpMessagePayload")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_method(StrEq("GetCachedMessageTypeSupport")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_method(StrEq("GetCachedVersionSupport")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_method(StrEq("GetCachedUuid")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_method(StrEq("GetCachedVdmSupport")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*objectServerMock->dbusIfMock,
+                register_method(StrEq("GetControlRequestStatistics")))
+        .Times(1)
+        .WillRepeatedly(Return(true));
+
     EXPECT_CALL(
         *objectServerMock->dbusIfMock,
         register_property(StrEq("ArpMasterSupport"), An<bool>(),
@@ -143,6 +193,630 @@ TEST_F(MctpdBaseTest, BaseIfPropertyTest)
     bindingPtr->initializeBinding();
 }
 
+constexpr mctp_eid_t testOwnEid = 8;
+constexpr mctp_eid_t testDestEid = 10;
+constexpr uint8_t testDestSlaveAddr = 0x20;
+
+struct SentPacket
+{
+    mctp_eid_t dest;
+    uint8_t tag;
+    std::vector<uint8_t> payload;
+};
+static std::vector<SentPacket> sentPackets;
+
+/*
+ * Binding which records every packet instead of sending it, so tests can
+ * check what went on the bus and answer it.
+ */
+static int recordingBindingTx(struct mctp_binding*, struct mctp_pktbuf* pkt)
+{
+    const mctp_hdr* hdr = mctp_pktbuf_hdr(pkt);
+    const uint8_t* data = static_cast<const uint8_t*>(mctp_pktbuf_data(pkt));
+    sentPackets.push_back(
+        {hdr->dest,
+         static_cast<uint8_t>((hdr->flags_seq_tag >> MCTP_HDR_TAG_SHIFT) &
+                              MCTP_HDR_TAG_MASK),
+         std::vector<uint8_t>(data, data + mctp_pktbuf_size(pkt) -
+                                        sizeof(mctp_hdr))});
+    return 0;
+}
+
+/*
+ * Gives the tests access to binding internals which are otherwise only
+ * reachable through hardware events.
+ */
+class MctpdTest
+{
+  public:
+    static struct mctp* initializeMctp(MctpBinding& binding)
+    {
+        binding.initializeMctp();
+        mctp_set_log_stdio(MCTP_LOG_ERR);
+        return binding.mctp;
+    }
+
+    static MctpTransmissionQueue& transmissionQueue(MctpBinding& binding)
+    {
+        return binding.transmissionQueue;
+    }
+
+    static std::vector<uint8_t>
+        sendReceive(MctpBinding& binding, boost::asio::yield_context yield,
+                    mctp_eid_t dstEid, std::vector<uint8_t> payload,
+                    bool idempotent)
+    {
+        constexpr uint16_t timeout = 1000;
+        return binding.sendReceiveMctpMessage(yield, dstEid, std::move(payload),
+                                              timeout, idempotent);
+    }
+
+    static MctpBinding& getResponseBinding(MctpBinding& binding,
+                                           mctp_eid_t srcEid, uint8_t msgTag)
+    {
+        return binding.getResponseBinding(srcEid, msgTag);
+    }
+
+    static void rxMessage(MctpBinding& binding, mctp_eid_t srcEid,
+                          std::vector<uint8_t>& msg, bool tagOwner,
+                          uint8_t msgTag)
+    {
+        MctpBinding::rxMessage(srcEid, &binding, msg.data(), msg.size(),
+                               tagOwner, msgTag, nullptr);
+    }
+
+    static void updateCapabilityCache(MctpBinding& binding, mctp_eid_t eid,
+                                      const std::vector<uint8_t>& msgTypes)
+    {
+        binding.updateCapabilityCache(eid, msgTypes, {});
+    }
+
+    static bool isCached(MctpBinding& binding, mctp_eid_t eid)
+    {
+        return binding.capabilityCache.count(eid) != 0;
+    }
+
+    static EndpointCapabilities& getCachedCapabilities(MctpBinding& binding,
+                                                       mctp_eid_t eid)
+    {
+        return binding.getCachedCapabilities(eid);
+    }
+
+    static std::vector<uint32_t> getCachedVersions(MctpBinding& binding,
+                                                   mctp_eid_t eid,
+                                                   uint8_t msgType)
+    {
+        return binding.getCachedVersions(eid, msgType);
+    }
+
+    static std::vector<std::vector<uint8_t>>
+        getCachedVdmSupport(MctpBinding& binding, mctp_eid_t eid)
+    {
+        return binding.getCachedVdmSupport(eid);
+    }
+
+    static void startCapabilityFetch(MctpBinding& binding, mctp_eid_t eid)
+    {
+        binding.startCapabilityFetch(eid);
+    }
+
+    static void discoveryNotify(MctpBinding& binding, mctp_eid_t srcEid)
+    {
+        std::vector<uint8_t> request;
+        std::vector<uint8_t> response;
+        binding.handleDiscoveryNotify(srcEid, nullptr, request, response);
+    }
+
+    static void runRediscovery(MctpBinding& binding)
+    {
+        binding.runRediscovery();
+    }
+
+    static bool isCtrlReqAllowed(MctpBinding& binding, mctp_eid_t srcEid,
+                                 uint8_t slaveAddr, int fd = 0)
+    {
+        mctp_smbus_extra_params params = {};
+        params.fd = fd;
+        params.slave_addr = static_cast<uint8_t>(slaveAddr << 1);
+        return binding.isCtrlReqAllowed(srcEid, &params);
+    }
+
+    static void rediscoverDevice(SMBusBinding& binding, uint8_t slaveAddr,
+                                 int fd = 0)
+    {
+        binding.rediscoverDevice(fd, static_cast<uint8_t>(slaveAddr << 1));
+    }
+
+    static std::vector<mctp_eid_t> getDeviceEids(SMBusBinding& binding)
+    {
+        std::vector<mctp_eid_t> eids;
+        for (const auto& device : binding.smbusDeviceTable)
+        {
+            eids.push_back(device.first);
+        }
+        return eids;
+    }
+
+    static size_t getQueuedRegistrations(SMBusBinding& binding)
+    {
+        return binding.registrationQueue.size();
+    }
+
+    static std::set<mctp_eid_t> getEidPool(MctpBinding& binding)
+    {
+        std::set<mctp_eid_t> pool;
+        for (const auto& eidPair : binding.eidPoolMap)
+        {
+            pool.insert(eidPair.first);
+        }
+        return pool;
+    }
+
+    static std::vector<uint8_t> getRoutingTable(MctpBinding& binding,
+                                                uint8_t entryHandle)
+    {
+        std::vector<uint8_t> request(sizeof(mctp_ctrl_cmd_get_routing_table));
+        reinterpret_cast<mctp_ctrl_cmd_get_routing_table*>(request.data())
+            ->entry_handle = entryHandle;
+        std::vector<uint8_t> response;
+        binding.handleGetRoutingTable(MCTP_EID_NULL, nullptr, request,
+                                      response);
+        return response;
+    }
+
+    static void addDevice(SMBusBinding& binding, mctp_eid_t eid,
+                          uint8_t slaveAddr, int fd = 0)
+    {
+        mctp_smbus_extra_params params = {};
+        params.fd = fd;
+        params.slave_addr = static_cast<uint8_t>(slaveAddr << 1);
+        binding.smbusDeviceTable.emplace_back(eid, params);
+    }
+};
+
+/*
+ * SMBus endpoint with one remote device, packets go to the recording
+ * binding.
+ */
+class MctpdBindingTest : public MctpdBaseTest
+{
+  public:
+    void SetUp() override
+    {
+        MctpdBaseTest::SetUp();
+        objectServerMock->dbusIfMock->returnByDefault(true);
+        MakeSmbusConfiguration(
+            mctp_server::MctpPhysicalMediumIdentifiers::SmbusI2c,
+            mctp_server::BindingModeTypes::Endpoint, testOwnEid, {}, "");
+        auto& smbusConfig = std::get<SMBusConfiguration>(testConfiguration);
+        smbusConfig.reqToRespTime = 100;
+        smbusConfig.reqRetryCount = 2;
+        binding = std::make_unique<SMBusBinding>(
+            objectServerMock, mctpBaseObj, testConfiguration, ioc);
+
+        mctp = MctpdTest::initializeMctp(*binding);
+        recordingBinding = {};
+        recordingBinding.name = "test";
+        recordingBinding.version = 1;
+        recordingBinding.pkt_size = MCTP_PACKET_SIZE(MCTP_BTU);
+        recordingBinding.tx = recordingBindingTx;
+        mctp_register_bus(mctp, &recordingBinding, testOwnEid);
+        mctp_binding_set_tx_enabled(&recordingBinding, true);
+
+        MctpdTest::addDevice(*binding, testDestEid, testDestSlaveAddr);
+        sentPackets.clear();
+    }
+
+    void TearDown() override
+    {
+        binding.reset();
+    }
+
+    boost::asio::io_context ioc;
+    std::unique_ptr<SMBusBinding> binding;
+    struct mctp* mctp = nullptr;
+    struct mctp_binding recordingBinding;
+};
+
+// PLDM GetPDR request, only the instance ID differs between requesters
+static std::vector<uint8_t> makePldmRequest(uint8_t instanceId)
+{
+    return {MCTP_MESSAGE_TYPE_PLDM, static_cast<uint8_t>(0x80 | instanceId),
+            0x02, 0x51, 0x00, 0x00, 0x00, 0x00};
+}
+
+static std::vector<uint8_t> makePldmResponse(const std::vector<uint8_t>& req)
+{
+    return {MCTP_MESSAGE_TYPE_PLDM, static_cast<uint8_t>(req[1] & 0x1F),
+            req[2], req[3], 0x00};
+}
+
+/*
+ * Identical idempotent requests in flight go on the bus once and every
+ * requester gets the response with its own instance ID.
+ */
+TEST_F(MctpdBindingTest, IdempotentRequestsShareTransmit)
+{
+    std::vector<std::vector<uint8_t>> responses(2);
+    for (uint8_t i = 0; i < responses.size(); i++)
+    {
+        boost::asio::spawn(
+            ioc, [this, i, &responses](boost::asio::yield_context yield) {
+                responses[i] = MctpdTest::sendReceive(
+                    *binding, yield, testDestEid, makePldmRequest(i), true);
+            });
+    }
+    ioc.poll();
+    ASSERT_EQ(1u, sentPackets.size());
+    EXPECT_EQ(testDestEid, sentPackets[0].dest);
+
+    auto response = makePldmResponse(sentPackets[0].payload);
+    MctpdTest::rxMessage(*binding, testDestEid, response, false,
+                         sentPackets[0].tag);
+    ioc.poll();
+
+    EXPECT_EQ(1u, sentPackets.size());
+    for (uint8_t i = 0; i < responses.size(); i++)
+    {
+        ASSERT_EQ(response.size(), responses[i].size());
+        EXPECT_EQ(i, responses[i][1] & 0x1F);
+    }
+}
+
+/*
+ * Non idempotent requests are never coalesced.
+ */
+TEST_F(MctpdBindingTest, RequestsNotCoalescedByDefault)
+{
+    auto& queue = MctpdTest::transmissionQueue(*binding);
+    queue.transmit(mctp, testDestEid, makePldmRequest(0), {}, ioc);
+    queue.transmit(mctp, testDestEid, makePldmRequest(1), {}, ioc);
+    EXPECT_EQ(2u, sentPackets.size());
+}
+
+/*
+ * Tag freed by a request which timed out is handed to the next queued one
+ * straight away.
+ */
+TEST_F(MctpdBindingTest, DisposeTransmitsQueuedMessage)
+{
+    constexpr uint8_t tagCount = 8;
+    auto& queue = MctpdTest::transmissionQueue(*binding);
+    std::vector<std::shared_ptr<MctpTransmissionQueue::Message>> messages;
+    for (uint8_t i = 0; i <= tagCount; i++)
+    {
+        messages.emplace_back(
+            queue.transmit(mctp, testDestEid, makePldmRequest(i), {}, ioc));
+    }
+    ASSERT_EQ(tagCount, sentPackets.size());
+    EXPECT_FALSE(messages.back()->tag);
+
+    queue.dispose(mctp, testDestEid, messages.front());
+    ASSERT_EQ(tagCount + 1u, sentPackets.size());
+    ASSERT_TRUE(messages.back()->tag);
+    EXPECT_EQ(sentPackets.front().tag, messages.back()->tag.value());
+}
+
+// Successful response to a control request, body follows completion code
+static std::vector<uint8_t> makeCtrlResponse(const std::vector<uint8_t>& req,
+                                             std::vector<uint8_t> body)
+{
+    std::vector<uint8_t> resp = {
+        req[0], static_cast<uint8_t>(req[1] & MCTP_CTRL_HDR_INSTANCE_ID_MASK),
+        req[2], MCTP_CTRL_CC_SUCCESS};
+    resp.insert(resp.end(), body.begin(), body.end());
+    return resp;
+}
+
+/*
+ * Capabilities from discovery are served without any bus traffic.
+ */
+TEST_F(MctpdBindingTest, CachedMessageTypesNoBusTraffic)
+{
+    const std::vector<uint8_t> msgTypes = {MCTP_MESSAGE_TYPE_MCTP_CTRL,
+                                           MCTP_MESSAGE_TYPE_PLDM};
+    MctpdTest::updateCapabilityCache(*binding, testDestEid, msgTypes);
+
+    EXPECT_EQ(msgTypes,
+              MctpdTest::getCachedCapabilities(*binding, testDestEid).msgTypes);
+    EXPECT_TRUE(sentPackets.empty());
+}
+
+// Response to a control request carrying error completion code
+static std::vector<uint8_t> makeCtrlError(const std::vector<uint8_t>& req)
+{
+    auto resp = makeCtrlResponse(req, {});
+    resp[3] = MCTP_CTRL_CC_ERROR;
+    return resp;
+}
+
+/*
+ * Versions and VDM support are fetched in the background after discovery.
+ * Cached methods answer from memory only, error completion codes are cached
+ * as empty lists.
+ */
+TEST_F(MctpdBindingTest, CapabilitiesFetchedInBackground)
+{
+    MctpdTest::updateCapabilityCache(
+        *binding, testDestEid,
+        {MCTP_MESSAGE_TYPE_PLDM, MCTP_MESSAGE_TYPE_VDPCI});
+    EXPECT_THROW(MctpdTest::getCachedVersions(*binding, testDestEid,
+                                              MCTP_MESSAGE_TYPE_PLDM),
+                 std::system_error);
+    EXPECT_THROW(MctpdTest::getCachedVdmSupport(*binding, testDestEid),
+                 std::system_error);
+    EXPECT_TRUE(sentPackets.empty());
+
+    MctpdTest::startCapabilityFetch(*binding, testDestEid);
+    ioc.poll();
+    ASSERT_EQ(1u, sentPackets.size());
+    auto pldmVersions =
+        makeCtrlResponse(sentPackets[0].payload, {1, 0xF1, 0xF0, 0xF0, 0x00});
+    MctpdTest::rxMessage(*binding, testDestEid, pldmVersions, false,
+                         sentPackets[0].tag);
+    ioc.poll();
+
+    ASSERT_EQ(2u, sentPackets.size());
+    auto vdpciVersions = makeCtrlError(sentPackets[1].payload);
+    MctpdTest::rxMessage(*binding, testDestEid, vdpciVersions, false,
+                         sentPackets[1].tag);
+    ioc.poll();
+
+    ASSERT_EQ(3u, sentPackets.size());
+    auto vdmSupport = makeCtrlError(sentPackets[2].payload);
+    MctpdTest::rxMessage(*binding, testDestEid, vdmSupport, false,
+                         sentPackets[2].tag);
+    ioc.poll();
+
+    EXPECT_EQ(std::vector<uint32_t>{0xF1F0F000},
+              MctpdTest::getCachedVersions(*binding, testDestEid,
+                                           MCTP_MESSAGE_TYPE_PLDM));
+    EXPECT_THROW(MctpdTest::getCachedVersions(*binding, testDestEid,
+                                              MCTP_MESSAGE_TYPE_VDPCI),
+                 std::system_error);
+    EXPECT_TRUE(
+        MctpdTest::getCachedVdmSupport(*binding, testDestEid).empty());
+    EXPECT_EQ(3u, sentPackets.size());
+}
+
+/*
+ * Discovery Notify invalidates the capabilities of the sender only, they
+ * are fetched again by the rediscovery.
+ */
+TEST_F(MctpdBindingTest, DiscoveryNotifyRefreshesSender)
+{
+    constexpr mctp_eid_t otherEid = testDestEid + 1;
+    MctpdTest::updateCapabilityCache(*binding, testDestEid,
+                                     {MCTP_MESSAGE_TYPE_MCTP_CTRL});
+    MctpdTest::updateCapabilityCache(*binding, otherEid,
+                                     {MCTP_MESSAGE_TYPE_MCTP_CTRL});
+
+    MctpdTest::discoveryNotify(*binding, MCTP_EID_NULL);
+    EXPECT_TRUE(MctpdTest::isCached(*binding, testDestEid));
+    EXPECT_TRUE(MctpdTest::isCached(*binding, otherEid));
+
+    MctpdTest::discoveryNotify(*binding, testDestEid);
+    EXPECT_FALSE(MctpdTest::isCached(*binding, testDestEid));
+    EXPECT_TRUE(MctpdTest::isCached(*binding, otherEid));
+
+    MctpdTest::runRediscovery(*binding);
+    ioc.poll();
+    ASSERT_EQ(1u, sentPackets.size());
+    EXPECT_EQ(testDestEid, sentPackets[0].dest);
+    auto msgTypeResponse = makeCtrlResponse(
+        sentPackets[0].payload,
+        {2, MCTP_MESSAGE_TYPE_MCTP_CTRL, MCTP_MESSAGE_TYPE_PLDM});
+    MctpdTest::rxMessage(*binding, testDestEid, msgTypeResponse, false,
+                         sentPackets[0].tag);
+    ioc.poll();
+
+    ASSERT_EQ(2u, sentPackets.size());
+    auto uuidResponse =
+        makeCtrlResponse(sentPackets[1].payload, std::vector<uint8_t>(16));
+    MctpdTest::rxMessage(*binding, testDestEid, uuidResponse, false,
+                         sentPackets[1].tag);
+    ioc.poll();
+
+    ASSERT_TRUE(MctpdTest::isCached(*binding, testDestEid));
+    EXPECT_EQ((std::vector<uint8_t>{MCTP_MESSAGE_TYPE_MCTP_CTRL,
+                                    MCTP_MESSAGE_TYPE_PLDM}),
+              MctpdTest::getCachedCapabilities(*binding, testDestEid).msgTypes);
+}
+
+/*
+ * Requesters without EID are rate limited by their physical address, one
+ * flooding device does not starve the others.
+ */
+TEST_F(MctpdBindingTest, CtrlRequestRateLimitPerAddress)
+{
+    constexpr uint8_t otherSlaveAddr = testDestSlaveAddr + 1;
+    constexpr unsigned int rateLimit = 16;
+    for (unsigned int i = 0; i < rateLimit; i++)
+    {
+        EXPECT_TRUE(MctpdTest::isCtrlReqAllowed(*binding, MCTP_EID_NULL,
+                                                testDestSlaveAddr));
+    }
+    EXPECT_FALSE(MctpdTest::isCtrlReqAllowed(*binding, MCTP_EID_NULL,
+                                             testDestSlaveAddr));
+    EXPECT_TRUE(MctpdTest::isCtrlReqAllowed(*binding, MCTP_EID_NULL,
+                                            otherSlaveAddr));
+    // Same address behind another mux channel has its own budget
+    EXPECT_TRUE(MctpdTest::isCtrlReqAllowed(*binding, MCTP_EID_NULL,
+                                            testDestSlaveAddr, 1));
+}
+
+/*
+ * Bus owner registers again only the device which sent Discovery Notify,
+ * other endpoints stay as they are.
+ */
+TEST_F(MctpdBaseTest, RediscoveryOnlyNotifyingDevice)
+{
+    constexpr mctp_eid_t otherEid = testDestEid + 1;
+    constexpr uint8_t otherSlaveAddr = testDestSlaveAddr + 1;
+    objectServerMock->dbusIfMock->returnByDefault(true);
+    MakeSmbusConfiguration(mctp_server::MctpPhysicalMediumIdentifiers::SmbusI2c,
+                           mctp_server::BindingModeTypes::BusOwner, testOwnEid,
+                           {testDestEid, otherEid}, "");
+    boost::asio::io_context ioc;
+    SMBusBinding binding(objectServerMock, mctpBaseObj, testConfiguration,
+                         ioc);
+    MctpdTest::addDevice(binding, testDestEid, testDestSlaveAddr);
+    MctpdTest::addDevice(binding, otherEid, otherSlaveAddr);
+
+    MctpdTest::rediscoverDevice(binding, testDestSlaveAddr);
+    EXPECT_EQ(std::vector<mctp_eid_t>{otherEid},
+              MctpdTest::getDeviceEids(binding));
+    EXPECT_EQ(1u, MctpdTest::getQueuedRegistrations(binding));
+
+    // Notify received again before registration started is folded into it
+    MctpdTest::rediscoverDevice(binding, testDestSlaveAddr);
+    EXPECT_EQ(1u, MctpdTest::getQueuedRegistrations(binding));
+}
+
+/*
+ * Identical devices behind different mux channels share the address, only
+ * the one on the channel the notify came from is registered again.
+ */
+TEST_F(MctpdBaseTest, RediscoveryOnlyNotifyingMuxChannel)
+{
+    constexpr mctp_eid_t otherEid = testDestEid + 1;
+    constexpr int muxFd = 10;
+    constexpr int otherMuxFd = 11;
+    objectServerMock->dbusIfMock->returnByDefault(true);
+    MakeSmbusConfiguration(mctp_server::MctpPhysicalMediumIdentifiers::SmbusI2c,
+                           mctp_server::BindingModeTypes::BusOwner, testOwnEid,
+                           {testDestEid, otherEid}, "");
+    boost::asio::io_context ioc;
+    SMBusBinding binding(objectServerMock, mctpBaseObj, testConfiguration,
+                         ioc);
+    MctpdTest::addDevice(binding, testDestEid, testDestSlaveAddr, muxFd);
+    MctpdTest::addDevice(binding, otherEid, testDestSlaveAddr, otherMuxFd);
+
+    MctpdTest::rediscoverDevice(binding, testDestSlaveAddr, otherMuxFd);
+    EXPECT_EQ(std::vector<mctp_eid_t>{testDestEid},
+              MctpdTest::getDeviceEids(binding));
+    EXPECT_EQ(1u, MctpdTest::getQueuedRegistrations(binding));
+}
+
+/*
+ * Two SMBus networks bridged in one process.
+ */
+class MctpdBridgeTest : public MctpdBaseTest
+{
+  public:
+    void SetUp() override
+    {
+        MctpdBaseTest::SetUp();
+        objectServerMock->dbusIfMock->returnByDefault(true);
+    }
+
+    std::unique_ptr<SMBusBinding> makeBinding(std::set<uint8_t> eidPool)
+    {
+        MakeSmbusConfiguration(
+            mctp_server::MctpPhysicalMediumIdentifiers::SmbusI2c,
+            mctp_server::BindingModeTypes::BusOwner, testOwnEid, eidPool, "");
+        auto binding = std::make_unique<SMBusBinding>(
+            objectServerMock, mctpBaseObj, testConfiguration, ioc);
+        bridge.addBinding(binding.get());
+        return binding;
+    }
+
+    boost::asio::io_context ioc;
+    MctpBridge bridge;
+};
+
+/*
+ * EID pools are trimmed to one EID space, EID routed to one network is not
+ * accepted from the other one.
+ */
+TEST_F(MctpdBridgeTest, EidCollisionRejected)
+{
+    auto first = makeBinding({10, 11});
+    auto second = makeBinding({11, 12});
+    EXPECT_EQ((std::set<mctp_eid_t>{10, 11}), MctpdTest::getEidPool(*first));
+    EXPECT_EQ(std::set<mctp_eid_t>{12}, MctpdTest::getEidPool(*second));
+
+    EXPECT_TRUE(bridge.addRoute(20, first.get()));
+    EXPECT_FALSE(bridge.addRoute(20, second.get()));
+    EXPECT_EQ(first.get(), bridge.getRoute(20));
+    EXPECT_FALSE(bridge.addRoute(11, second.get()));
+    EXPECT_FALSE(bridge.addRoute(MCTP_EID_NULL, first.get()));
+    EXPECT_FALSE(bridge.addRoute(MCTP_EID_BROADCAST, first.get()));
+
+    bridge.removeRoute(20, first.get());
+    EXPECT_TRUE(bridge.addRoute(20, second.get()));
+}
+
+/*
+ * Full routing table is reported across several responses, the last one
+ * ends with handle 0xFF.
+ */
+TEST_F(MctpdBridgeTest, RoutingTableEntriesPaged)
+{
+    auto first = makeBinding({});
+    auto second = makeBinding({});
+    for (unsigned int eid = 1; eid < MCTP_EID_BROADCAST; eid++)
+    {
+        ASSERT_TRUE(bridge.addRoute(static_cast<mctp_eid_t>(eid),
+                                    eid % 2 ? first.get() : second.get()));
+    }
+
+    std::set<mctp_eid_t> reported;
+    uint8_t entryHandle = 0;
+    size_t responses = 0;
+    while (entryHandle != 0xFF && responses++ < MCTP_EID_BROADCAST)
+    {
+        auto response = MctpdTest::getRoutingTable(*first, entryHandle);
+        ASSERT_GE(response.size(), sizeof(mctp_ctrl_resp_get_routing_table));
+        auto resp = reinterpret_cast<mctp_ctrl_resp_get_routing_table*>(
+            response.data());
+        ASSERT_EQ(MCTP_CTRL_CC_SUCCESS, resp->completion_code);
+        ASSERT_NE(0, resp->number_of_entries);
+
+        size_t offset = sizeof(mctp_ctrl_resp_get_routing_table);
+        for (uint8_t i = 0; i < resp->number_of_entries; i++)
+        {
+            ASSERT_LE(offset + sizeof(get_routing_table_entry),
+                      response.size());
+            auto entry = reinterpret_cast<get_routing_table_entry*>(
+                response.data() + offset);
+            reported.insert(entry->starting_eid);
+            offset += sizeof(get_routing_table_entry) +
+                      entry->phys_address_size;
+        }
+        entryHandle = resp->next_entry_handle;
+    }
+    EXPECT_EQ(0xFF, entryHandle);
+    EXPECT_EQ(static_cast<size_t>(MCTP_EID_BROADCAST - 1), reported.size());
+}
+
+/*
+ * Response to a request sent through one service to an EID in the other
+ * network is signalled on the requester's service, once.
+ */
+TEST_F(MctpdBridgeTest, BridgedResponseSignalledToRequester)
+{
+    constexpr mctp_eid_t remoteEid = 20;
+    constexpr uint8_t msgTag = 3;
+    auto first = makeBinding({});
+    auto second = makeBinding({});
+    ASSERT_TRUE(bridge.addRoute(remoteEid, second.get()));
+    bridge.addRequester(remoteEid, msgTag, first.get());
+
+    EXPECT_EQ(second.get(), &MctpdTest::getResponseBinding(
+                                *second, remoteEid, msgTag + 1));
+    EXPECT_EQ(first.get(),
+              &MctpdTest::getResponseBinding(*second, remoteEid, msgTag));
+    EXPECT_EQ(second.get(),
+              &MctpdTest::getResponseBinding(*second, remoteEid, msgTag));
+
+    // Newer request with the same tag takes it over
+    bridge.addRequester(remoteEid, msgTag, first.get());
+    bridge.addRequester(remoteEid, msgTag, second.get());
+    EXPECT_EQ(second.get(), bridge.takeRequester(remoteEid, msgTag));
+    EXPECT_EQ(nullptr, bridge.takeRequester(remoteEid, msgTag));
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,62 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pldm
+{
+namespace metrics
+{
+
+// Upper bounds of latency histogram buckets in us, last bucket is unbounded
+inline const std::vector<uint32_t> latencyBuckets = {
+    500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000};
+
+/** @brief Counters and latency histogram of one command */
+struct CommandMetrics
+{
+    uint32_t count = 0;
+    uint32_t failures = 0;
+    uint32_t retries = 0;
+    uint64_t totalLatency = 0;
+    std::vector<uint32_t> histogram =
+        std::vector<uint32_t>(latencyBuckets.size() + 1);
+
+    void record(const bool success, const size_t retryCount,
+                const std::chrono::microseconds latency)
+    {
+        count++;
+        if (!success)
+        {
+            failures++;
+        }
+        retries += static_cast<uint32_t>(retryCount);
+        auto latencyUs = static_cast<uint64_t>(latency.count());
+        totalLatency += latencyUs;
+
+        auto bucket = std::lower_bound(latencyBuckets.begin(),
+                                       latencyBuckets.end(), latencyUs);
+        histogram[static_cast<size_t>(bucket - latencyBuckets.begin())]++;
+    }
+};
+
+} // namespace metrics
+} // namespace pldm
@@ -0,0 +1,39 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "mctpw.h"
+
+namespace pldm
+{
+
+/** @brief Index of MCTP network, every MCTP service has own EID space */
+using NetworkId = uint8_t;
+
+namespace transport
+{
+
+/** @brief MCTP endpoint address, EIDs are unique only within a network */
+struct Endpoint
+{
+    NetworkId network;
+    mctpw_eid_t eid;
+};
+
+} // namespace transport
+} // namespace pldm
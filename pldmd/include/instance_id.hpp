@@ -0,0 +1,100 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdint>
+
+#include "base.h"
+
+namespace pldm
+{
+
+// Instance ID expiration interval(DSP0240), after it requester may reuse the
+// instance ID of a request which got no response
+constexpr std::chrono::seconds instanceIdExpiry(5);
+
+/** @brief Tracks instance IDs in flight for one endpoint
+ *
+ * Each ID carries the time it becomes free again. Allocated ID is reserved
+ * for the expiration interval so that IDs never sent are reclaimed, ID being
+ * sent is held until the exchange is over. Waiters for an ID park on a timer
+ * armed to the earliest expiry and are woken on every release.
+ */
+class InstanceIdAllocator
+{
+  public:
+    explicit InstanceIdAllocator(boost::asio::io_context& ioc) :
+        timer(ioc, std::chrono::steady_clock::time_point::max())
+    {
+        freeAt.fill(std::chrono::steady_clock::time_point::min());
+    }
+
+    uint8_t allocate(boost::asio::yield_context yield)
+    {
+        while (true)
+        {
+            auto now = std::chrono::steady_clock::now();
+            // Round robin, recently released IDs are reused last
+            for (size_t i = 0; i < freeAt.size(); i++)
+            {
+                uint8_t id = (next + i) & PLDM_INSTANCE_ID_MASK;
+                if (freeAt[id] <= now)
+                {
+                    freeAt[id] = now + instanceIdExpiry;
+                    next = (id + 1) & PLDM_INSTANCE_ID_MASK;
+                    return id;
+                }
+            }
+
+            // Rearming the timer aborts other waiters, do it only if needed
+            auto earliest = *std::min_element(freeAt.begin(), freeAt.end());
+            if (timer.expiry() != earliest)
+            {
+                timer.expires_at(earliest);
+            }
+            boost::system::error_code ec;
+            timer.async_wait(yield[ec]);
+        }
+    }
+
+    // Marks ID as in flight until release
+    void hold(const uint8_t id)
+    {
+        freeAt[id] = std::chrono::steady_clock::time_point::max();
+    }
+
+    // ID of a request without response is not reused until it expires, late
+    // response must not be matched with a new request
+    void release(const uint8_t id, const bool responded)
+    {
+        freeAt[id] = responded
+                         ? std::chrono::steady_clock::time_point::min()
+                         : std::chrono::steady_clock::now() + instanceIdExpiry;
+        timer.cancel();
+    }
+
+  private:
+    boost::asio::steady_timer timer;
+    std::array<std::chrono::steady_clock::time_point, PLDM_INSTANCE_MAX> freeAt;
+    uint8_t next = 0;
+};
+
+} // namespace pldm
@@ -0,0 +1,108 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base.h"
+
+namespace pldm
+{
+
+/** @brief PLDM message buffer
+ *
+ * Storage reserves headroom in front of the PLDM message so that transport
+ * headers(MCTP message type, vendor defined headers) are prepended and
+ * stripped by moving the message start instead of the data. Storage is taken
+ * from a pool and returned to it on destruction, so its capacity is reused by
+ * the next message.
+ */
+class MessageBuffer
+{
+  public:
+    /** @brief Bytes available for transport headers */
+    static constexpr size_t headroom = 8;
+
+    /** @brief Creates buffer for PLDM message of given size(header included)
+     */
+    explicit MessageBuffer(const size_t size = 0);
+    ~MessageBuffer();
+
+    MessageBuffer(MessageBuffer&& other) noexcept;
+    MessageBuffer& operator=(MessageBuffer&& other) noexcept;
+    MessageBuffer(const MessageBuffer&) = delete;
+    MessageBuffer& operator=(const MessageBuffer&) = delete;
+
+    uint8_t* data()
+    {
+        return storage.data() + head;
+    }
+
+    const uint8_t* data() const
+    {
+        return storage.data() + head;
+    }
+
+    size_t size() const
+    {
+        return storage.size() - head;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    const uint8_t* begin() const
+    {
+        return data();
+    }
+
+    const uint8_t* end() const
+    {
+        return storage.data() + storage.size();
+    }
+
+    /** @brief PLDM message view, encoders write into it in place */
+    pldm_msg* msg()
+    {
+        return reinterpret_cast<pldm_msg*>(data());
+    }
+
+    /** @brief Resizes message, headroom is kept */
+    void resize(const size_t size)
+    {
+        storage.resize(head + size);
+    }
+
+    /** @brief Replaces content, data may start with transport headers */
+    void assign(const uint8_t* src, const size_t size);
+
+    /** @brief Prepends transport header byte, throws std::length_error if
+     * headroom is used up */
+    void pushFront(const uint8_t value);
+
+    /** @brief Strips bytes from message start */
+    void popFront(const size_t count = 1);
+
+  private:
+    std::vector<uint8_t> storage;
+    size_t head = headroom;
+};
+
+} // namespace pldm
@@ -16,9 +16,11 @@
 #pragma once
 
 #include "pldm.hpp"
+#include "sensor_poller.hpp"
 
 #include <boost/asio.hpp>
 
+#include "pdr.h"
 #include "platform.h"
 
 namespace pldm
@@ -40,16 +42,35 @@ class PDRManager
 
     bool pdrManagerInit(boost::asio::yield_context& yield);
 
+    /** @brief Sensors described by Numeric and State Sensor PDRs, except
+     * those disabled by their PDR*/
+    std::vector<Sensor> getSensors() const;
+
   private:
     /** @brief fetch PDR Repository Info from terminus*/
     std::optional<pldm_pdr_repository_info>
         getPDRRepositoryInfo(boost::asio::yield_context& yield);
 
+    /** @brief fetch one PDR, all of its parts, into the repository
+     *
+     * @return Handle of the next record, 0 after the last one
+     */
+    std::optional<uint32_t> getPDR(boost::asio::yield_context& yield,
+                                   const uint32_t recordHandle,
+                                   const uint16_t requestCount,
+                                   std::vector<uint8_t>& record);
+
+    /** @brief walk PDR repository of terminus from the first record*/
+    bool getPDRs(boost::asio::yield_context& yield);
+
     /** @brief PDR Repository Info of this terminus*/
     pldm_pdr_repository_info pdrRepoInfo;
 
     /** @brief Terminus ID*/
     pldm_tid_t _tid;
+
+    /** @brief PDRs fetched from this terminus*/
+    std::unique_ptr<pldm_pdr, decltype(&pldm_pdr_destroy)> _pdrRepo;
 };
 
 } // namespace platform
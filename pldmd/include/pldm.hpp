@@ -17,13 +17,16 @@
 
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
+#include <chrono>
 #include <memory>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 #include <vector>
 
 #include "base.h"
+#include "endpoint.hpp"
 #include "mctpw.h"
+#include "message_buffer.hpp"
 
 std::shared_ptr<boost::asio::io_context> getIoContext();
 std::shared_ptr<sdbusplus::asio::connection> getSdBus();
@@ -42,21 +45,154 @@ struct PLDMEmptyRequest
     struct pldm_msg_hdr header;
 } __attribute__((packed));
 
+/** @brief Bitmap of PLDM types supported by terminus, as returned by GetTypes
+ */
+using SupportedPLDMTypes = std::array<bitfield8_t, PLDM_MAX_TYPES / 8>;
+
 using PLDMCommandTable = std::vector<std::map<
     ver32_t, /*Supported PLDM Version*/
     std::array<bitfield8_t, PLDM_MAX_CMDS_PER_TYPE / 8> /*Supported PLDM
                                                            Commands*/
     >>;
 
+namespace transport
+{
+
+/** @brief Initialize MCTP transport router
+ *
+ * Discovers every MCTP service (one per binding and bus) and the endpoints
+ * each one owns. Each service is tracked as separate MCTP network. Routes are
+ * kept up to date from D-Bus signals afterwards, signals are accepted only
+ * from MCTP.Base owners and services started later are discovered from them.
+ * Every endpoint supporting PLDM is handed to addTerminus once its route is
+ * known, termini of removed endpoints are released, see removeTerminus.
+ *
+ * @param yield - Context object the represents the currently executing
+ * coroutine
+ *
+ * @return Status of the operation
+ */
+bool transportInit(boost::asio::yield_context yield);
+
+/** @brief Get network of MCTP service
+ *
+ * @param uniqueName - Unique D-Bus connection name of the service, e.g. sender
+ * of received message signal
+ *
+ * @return Network ID
+ */
+std::optional<NetworkId> getNetworkId(const std::string& uniqueName);
+
+/** @brief Get MCTP service owning the endpoint
+ *
+ * @param network - Network of the MCTP device
+ * @param eid - EID of the MCTP device
+ *
+ * @return D-Bus service name to send messages for the EID through
+ */
+std::optional<std::string> getMctpService(const NetworkId network,
+                                          const mctpw_eid_t eid);
+
+/** @brief Largest MCTP message the binding reassembles, libmctp limit */
+constexpr size_t defaultMaxMessageSize = 64 * 1024;
+
+/** @brief Get the largest MCTP message receivable from the network
+ *
+ * @param network - Network of the MCTP device
+ *
+ * @return Message size including MCTP message type, as reported by mctpd
+ */
+size_t getMaxMessageSize(const NetworkId network);
+
+} // namespace transport
+
+namespace rtt
+{
+
+/** @brief Get response timeout for the endpoint
+ *
+ * Timeout follows smoothed round trip time and its variance measured for the
+ * endpoint(RFC 6298) and doubles with every timed out request.
+ *
+ * @param dst - Endpoint the request is sent to
+ * @param initial - Timeout used until a round trip is measured
+ *
+ * @return Response timeout
+ */
+std::chrono::milliseconds getTimeout(const transport::Endpoint& dst,
+                                     const std::chrono::milliseconds initial);
+
+/** @brief Update endpoint estimate with measured round trip time */
+void addSample(const transport::Endpoint& dst,
+               const std::chrono::microseconds rtt);
+
+/** @brief Back off endpoint timeout after request got no response */
+void onTimeout(const transport::Endpoint& dst);
+
+/** @brief Get randomised delay before a retry
+ *
+ * @param retry - Number of the retry, starting from 1
+ *
+ * @return Delay chosen uniformly up to exponentially growing limit
+ */
+std::chrono::milliseconds getBackoffDelay(const size_t retry);
+
+/** @brief Expose estimator state of all endpoints on D-Bus */
+void registerDiagnostics();
+
+} // namespace rtt
+
+namespace metrics
+{
+
+/** @brief Record completed PLDM request/response exchange
+ *
+ * Exchanges are accounted to the endpoint, so requests sent before TID
+ * assignment are not mixed across termini.
+ *
+ * @param endpoint - MCTP endpoint the request was sent to
+ * @param pldmType - PLDM type of the command
+ * @param command - PLDM command code
+ * @param success - False if no valid response was received
+ * @param retries - Number of attempts beyond the first one
+ * @param latency - Time from first attempt till completion
+ */
+void record(const transport::Endpoint& endpoint, const uint8_t pldmType,
+            const uint8_t command, const bool success, const size_t retries,
+            const std::chrono::microseconds latency);
+
+/** @brief Expose per command counters and latency histograms on D-Bus */
+void registerInterface();
+
+} // namespace metrics
+
 /** @brief Creates new Instance ID for PLDM messages
  *
- * Generated instance ID will be unique for each TID
+ * Generated instance ID is not in flight for the endpoint of the TID. It
+ * stays reserved until the request is answered by sendReceivePldmMessage or,
+ * if never sent, until the instance ID expiration interval passes. Waits when
+ * all instance IDs of the endpoint are in flight.
  *
+ * @param yield - Context object for coroutine
  * @param tid - TID of the PLDM device
  *
  * @return PLDM Instance ID
  */
-uint8_t createInstanceId(pldm_tid_t tid);
+uint8_t createInstanceId(boost::asio::yield_context yield, pldm_tid_t tid);
+
+/** @brief Creates new Instance ID for PLDM messages sent by EID
+ *
+ * Used before TID is assigned, IDs are shared with requests sent by TID of
+ * the same endpoint.
+ *
+ * @param yield - Context object for coroutine
+ * @param eid - EID of the MCTP device
+ * @param network - Network of the MCTP device
+ *
+ * @return PLDM Instance ID
+ */
+uint8_t createInstanceId(boost::asio::yield_context yield,
+                         const mctpw_eid_t eid, const NetworkId network);
 
 /** @brief Returns PLDM message Instance ID
  *
@@ -80,25 +216,54 @@ std::optional<uint8_t> getInstanceId(std::vector<uint8_t>& message);
  * @param yield - Context object the represents the currently executing
  * coroutine
  * @param tid - TID of the PLDM device
- * @param timeout - Maximum time period within the response is expected
- * @param pldmReq - PLDM request message
- * @param pldmResp - PLDM response message(Pass empty vector to capture
- * response)
+ * @param timeout - Response timeout in ms used until round trip time of the
+ * endpoint is measured, see rtt::getTimeout
+ * @param retryCount - Number of attempts, retries are delayed by randomised
+ * exponential backoff
+ * @param pldmReq - PLDM request message, left unchanged on return
+ * @param pldmResp - PLDM response message, previous content is replaced
  * @param eid - EID of the MCTP device
+ * @param network - Network of the MCTP device, used along with eid
  *
  * @return Status of the operation
  */
 bool sendReceivePldmMessage(boost::asio::yield_context yield,
                             const pldm_tid_t tid, const uint16_t timeout,
-                            size_t retryCount, std::vector<uint8_t> pldmReq,
-                            std::vector<uint8_t>& pldmResp,
-                            std::optional<mctpw_eid_t> eid = std::nullopt);
+                            size_t retryCount, MessageBuffer& pldmReq,
+                            MessageBuffer& pldmResp,
+                            std::optional<mctpw_eid_t> eid = std::nullopt,
+                            const NetworkId network = 0);
 
-// Helper functions to manage EID-TID mapping
+// Helper functions to manage EID-TID mapping. Lookups in both directions are
+// constant time, mapper generation changes with every mapping update.
 std::optional<pldm_tid_t> allocateTid();
-void addToMapper(const pldm_tid_t tid, const mctpw_eid_t eid);
-std::optional<pldm_tid_t> getTidFromMapper(const mctpw_eid_t eid);
+void addToMapper(const pldm_tid_t tid, const mctpw_eid_t eid,
+                 const NetworkId network);
+void removeFromMapper(const pldm_tid_t tid);
+std::optional<pldm_tid_t> getTidFromMapper(const mctpw_eid_t eid,
+                                           const NetworkId network);
 std::optional<mctpw_eid_t> getEidFromMapper(const pldm_tid_t tid);
+std::optional<transport::Endpoint> getEndpointFromMapper(const pldm_tid_t tid);
+uint32_t getMapperGeneration();
+
+/** @brief Initialise terminus of endpoint supporting PLDM
+ *
+ * Maps free TID to the endpoint and initialises the terminus in its own
+ * coroutine, limited by PLDM_INIT_CONCURRENCY. Already mapped endpoint is
+ * skipped.
+ *
+ * @param endpoint - MCTP endpoint which got route
+ */
+void addTerminus(const transport::Endpoint& endpoint);
+
+/** @brief Release terminus of endpoint which is no longer reachable
+ *
+ * Stops Platform Monitoring and Control, including sensor polling, of the
+ * terminus and removes its TID from the mapper.
+ *
+ * @param endpoint - Removed MCTP endpoint
+ */
+void removeTerminus(const transport::Endpoint& endpoint);
 
 /** @brief Validate PLDM message encode
  *
@@ -146,8 +311,24 @@ bool sendPldmMessage(const pldm_tid_t tid, const uint8_t msgTag,
 namespace base
 {
 
+/** @brief Initilize PLDM base
+ *
+ * @param yield - Context object the represents the currently executing
+ * coroutine
+ * @param eid - EID of the MCTP device
+ * @param network - Network of the MCTP device
+ * @param tid - TID of the PLDM device
+ * @param pldmTypes - PLDM types supported by the terminus
+ *
+ * @return Status of the operation
+ */
 bool baseInit(boost::asio::yield_context yield, const mctpw_eid_t eid,
-              pldm_tid_t& tid);
+              const NetworkId network, pldm_tid_t& tid,
+              SupportedPLDMTypes& pldmTypes);
+
+/** @brief Check if PLDM type is set in GetTypes bitmap */
+bool isPldmTypeSupported(const SupportedPLDMTypes& pldmTypes,
+                         const uint8_t pldmType);
 
 } // namespace base
 
@@ -180,6 +361,19 @@ bool platformInit(boost::asio::yield_context yield, const pldm_tid_t tid,
 
 bool platformDestroy(const pldm_tid_t tid);
 
+/** @brief Handle Platform Monitoring and Control request from terminus
+ *
+ * PlatformEventMessage sensor events update cached sensor readings and are
+ * acknowledged, other commands are rejected as unsupported.
+ *
+ * @param tid - TID of the PLDM device
+ * @param msgTag - MCTP message tag of the request
+ * @param tagOwner - MCTP tag owner bit of the request
+ * @param message - PLDM message
+ */
+void pldmMsgRecvCallback(const pldm_tid_t tid, const uint8_t msgTag,
+                         const bool tagOwner, std::vector<uint8_t>& message);
+
 } // namespace platform
 
 // TODO: add destroy APIs for Base, FRU and FWU
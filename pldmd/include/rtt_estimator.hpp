@@ -0,0 +1,115 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace pldm
+{
+namespace rtt
+{
+
+// Bounds keep a single slow sample from stalling the daemon and a fast
+// terminus from timing out on scheduling jitter. mctpd limits timeout to 16
+// bits anyway.
+constexpr std::chrono::milliseconds minTimeout(20);
+constexpr std::chrono::milliseconds maxTimeout(2000);
+constexpr std::chrono::microseconds clockGranularity(1000);
+
+/** @brief Round trip time estimator of one endpoint(RFC 6298)
+ *
+ * Timeout starts at the value given by the first caller and follows
+ * SRTT + 4 * RTTVAR once samples arrive, doubling on every timeout.
+ */
+class RttEstimator
+{
+  public:
+    std::chrono::milliseconds
+        getTimeout(const std::chrono::milliseconds initial)
+    {
+        if (timeout.count() == 0)
+        {
+            timeout = std::clamp(initial, minTimeout, maxTimeout);
+        }
+        return timeout;
+    }
+
+    void addSample(const std::chrono::microseconds rtt)
+    {
+        if (samples == 0)
+        {
+            srtt = rtt;
+            rttvar = rtt / 2;
+        }
+        else
+        {
+            // RTTVAR and SRTT gains of 1/4 and 1/8
+            std::chrono::microseconds delta =
+                srtt > rtt ? srtt - rtt : rtt - srtt;
+            rttvar = (3 * rttvar + delta) / 4;
+            srtt = (7 * srtt + rtt) / 8;
+        }
+        samples++;
+
+        auto rto = std::chrono::ceil<std::chrono::milliseconds>(
+            srtt + std::max(clockGranularity, 4 * rttvar));
+        timeout = std::clamp(rto, minTimeout, maxTimeout);
+    }
+
+    void onTimeout()
+    {
+        timeouts++;
+        timeout = std::min(2 * timeout, maxTimeout);
+    }
+
+    // Current timeout, zero until first use
+    std::chrono::milliseconds getRto() const
+    {
+        return timeout;
+    }
+
+    std::chrono::microseconds getSrtt() const
+    {
+        return srtt;
+    }
+
+    std::chrono::microseconds getRttvar() const
+    {
+        return rttvar;
+    }
+
+    uint32_t getSamples() const
+    {
+        return samples;
+    }
+
+    uint32_t getTimeouts() const
+    {
+        return timeouts;
+    }
+
+  private:
+    std::chrono::microseconds srtt{0};
+    std::chrono::microseconds rttvar{0};
+    std::chrono::milliseconds timeout{0};
+    uint32_t samples = 0;
+    uint32_t timeouts = 0;
+};
+
+} // namespace rtt
+} // namespace pldm
@@ -0,0 +1,135 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "pldm.hpp"
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "platform.h"
+
+namespace pldm
+{
+namespace platform
+{
+
+/** @brief Sensor described by Numeric Sensor or State Sensor PDR along with
+ * its latest reading
+ */
+struct Sensor
+{
+    enum class Type
+    {
+        numeric,
+        state
+    };
+
+    uint16_t id;
+    Type type;
+    /** @brief Number of state sensors composing state sensor */
+    uint8_t compositeCount = 1;
+    /** @brief Polling interval */
+    std::chrono::milliseconds interval;
+
+    /** @brief Conversion of numeric reading to PDR base unit */
+    real32_t resolution = 1;
+    real32_t offset = 0;
+    int8_t unitModifier = 0;
+
+    uint8_t operationalState = PLDM_SENSOR_STATUSUNKOWN;
+    /** @brief Numeric reading in base unit */
+    double value = 0;
+    /** @brief Present state of every composite state sensor */
+    std::array<uint8_t, 8> presentStates{};
+
+    /** @brief Events received since polling last found a change not reported
+     * by event */
+    uint32_t eventCount = 0;
+    /** @brief Polls started later than one interval after they were due */
+    uint32_t overruns = 0;
+
+    std::chrono::steady_clock::time_point nextPoll;
+    /** @brief Time of the latest reading, by poll or event */
+    std::chrono::steady_clock::time_point updated{};
+};
+
+/** @brief Sensor event carried by PlatformEventMessage */
+struct SensorEvent
+{
+    uint16_t sensorId;
+    /** @brief sensorEventClass, see sensor_event_class_states */
+    uint8_t eventClass;
+    /** @brief New sensorOperationalState for PLDM_SENSOR_OP_STATE */
+    uint8_t operationalState = PLDM_SENSOR_ENABLED;
+    /** @brief Composite sensor offset and its new state for
+     * PLDM_STATE_SENSOR_STATE */
+    uint8_t sensorOffset = 0;
+    uint8_t state = 0;
+    /** @brief Reading for PLDM_NUMERIC_SENSOR_STATE */
+    uint8_t dataSize = PLDM_SENSOR_DATA_SIZE_UINT8;
+    uint32_t presentReading = 0;
+};
+
+/** @brief Start polling sensors of the terminus
+ *
+ * Sensors of all termini are served by one scheduler. Each sensor is polled
+ * on its own interval, first polls are spread randomly over the interval.
+ * Number of outstanding requests is limited per terminus and per MCTP
+ * network, sensors due meanwhile wait in per terminus FIFO. Disabled and
+ * unavailable sensors are polled at low rate only to notice them coming
+ * back. Polls which could not be started on time are counted as overruns.
+ *
+ * @param tid - TID of the terminus
+ * @param sensors - Sensors to poll, replace sensors polled so far
+ */
+void startSensorPolling(const pldm_tid_t tid, std::vector<Sensor> sensors);
+
+/** @brief Update cached reading of the sensor from event
+ *
+ * State sensors which keep reporting their changes by events are polled only
+ * at low rate to verify no event was lost. Polling returns to sensor interval
+ * once it finds a change that was not reported.
+ *
+ * @param tid - TID of the terminus
+ * @param event - Decoded sensor event
+ *
+ * @return False if the terminus has no such sensor
+ */
+bool onSensorEvent(const pldm_tid_t tid, const SensorEvent& event);
+
+/** @brief Stop polling sensors of the terminus
+ *
+ * @param tid - TID of the terminus
+ */
+void stopSensorPolling(const pldm_tid_t tid);
+
+/** @brief Get the sensor with its latest reading
+ *
+ * @param tid - TID of the terminus
+ * @param sensorId - Sensor ID from the PDR
+ *
+ * @return Sensor, nullopt if the terminus is not polled or has no such sensor
+ */
+std::optional<Sensor> getSensor(const pldm_tid_t tid, const uint16_t sensorId);
+
+/** @brief Expose latest readings of polled sensors on D-Bus */
+void registerSensorReadings();
+
+} // namespace platform
+} // namespace pldm
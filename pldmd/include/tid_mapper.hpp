@@ -0,0 +1,111 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "base.h"
+#include "endpoint.hpp"
+
+namespace pldm
+{
+
+/** @brief 1:1 mapping between TID and MCTP endpoint
+ *
+ * EIDs are unique only within MCTP network so reverse lookup table is kept
+ * per network. EID 0 is MCTP null EID and TID 0 is unassigned TID, both mark
+ * free entries. Generation changes on every modification, so a caller which
+ * yielded can tell its cached mapping went stale.
+ */
+class TidMapper
+{
+  public:
+    std::optional<pldm_tid_t> getTid(const transport::Endpoint& endpoint) const
+    {
+        if (endpoint.network < eidToTid.size())
+        {
+            if (pldm_tid_t tid = eidToTid[endpoint.network][endpoint.eid])
+            {
+                return tid;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<transport::Endpoint> getEndpoint(const pldm_tid_t tid) const
+    {
+        const transport::Endpoint& entry = tidToEid[tid];
+        if (entry.eid != 0)
+        {
+            return entry;
+        }
+        return std::nullopt;
+    }
+
+    bool isFree(const pldm_tid_t tid) const
+    {
+        return tidToEid[tid].eid == 0;
+    }
+
+    // Previous mappings of both TID and endpoint are dropped
+    void add(const pldm_tid_t tid, const transport::Endpoint& endpoint)
+    {
+        remove(tid);
+        if (endpoint.network >= eidToTid.size())
+        {
+            eidToTid.resize(endpoint.network + 1, EidToTid{});
+        }
+        if (pldm_tid_t oldTid = eidToTid[endpoint.network][endpoint.eid])
+        {
+            tidToEid[oldTid] = transport::Endpoint{};
+        }
+        tidToEid[tid] = endpoint;
+        eidToTid[endpoint.network][endpoint.eid] = tid;
+        generation++;
+    }
+
+    void remove(const pldm_tid_t tid)
+    {
+        transport::Endpoint& entry = tidToEid[tid];
+        if (entry.eid == 0)
+        {
+            return;
+        }
+        if (entry.network < eidToTid.size() &&
+            eidToTid[entry.network][entry.eid] == tid)
+        {
+            eidToTid[entry.network][entry.eid] = 0;
+        }
+        entry = transport::Endpoint{};
+        generation++;
+    }
+
+    uint32_t getGeneration() const
+    {
+        return generation;
+    }
+
+  private:
+    using EidToTid = std::array<pldm_tid_t, 256>;
+    std::array<transport::Endpoint, 256> tidToEid{};
+    std::vector<EidToTid> eidToTid;
+    uint32_t generation = 0;
+};
+
+} // namespace pldm
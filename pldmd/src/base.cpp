@@ -27,8 +27,6 @@ constexpr uint16_t timeOut = 100;
 constexpr size_t retryCount = 3;
 constexpr size_t hdrSize = sizeof(pldm_msg_hdr);
 
-using SupportedPLDMTypes = std::array<bitfield8_t, 8>;
-
 static bool validateBaseReqEncode(const mctpw_eid_t eid, const int rc,
                                   const std::string& commandString)
 {
@@ -70,17 +68,16 @@ static bool validateBaseRespDecode(const mctpw_eid_t eid, const int rc,
 }
 
 bool getSupportedPLDMTypes(boost::asio::yield_context yield,
-                           const mctpw_eid_t eid,
+                           const mctpw_eid_t eid, const NetworkId network,
                            SupportedPLDMTypes& supportedTypes)
 {
     // A special TID is used in cases where TID is not assigned
     constexpr uint8_t specialTID = 0x00;
 
-    uint8_t instanceID = createInstanceId(specialTID);
-    std::vector<uint8_t> getSupportedPLDMTypesRequest(sizeof(PLDMEmptyRequest),
-                                                      0x00);
-    auto msg = reinterpret_cast<pldm_msg*>(getSupportedPLDMTypesRequest.data());
-    std::vector<uint8_t> getSupportedPLDMTypesResponse;
+    uint8_t instanceID = createInstanceId(yield, eid, network);
+    MessageBuffer getSupportedPLDMTypesRequest(sizeof(PLDMEmptyRequest));
+    auto msg = getSupportedPLDMTypesRequest.msg();
+    MessageBuffer getSupportedPLDMTypesResponse;
 
     int rc = encode_get_types_req(instanceID, msg);
     if (!validateBaseReqEncode(eid, rc, "GetTypes"))
@@ -91,7 +88,7 @@ bool getSupportedPLDMTypes(boost::asio::yield_context yield,
     // TID passed as 0 will be ignored since EID is present.
     if (!sendReceivePldmMessage(yield, specialTID, timeOut, retryCount,
                                 getSupportedPLDMTypesRequest,
-                                getSupportedPLDMTypesResponse, eid))
+                                getSupportedPLDMTypesResponse, eid, network))
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "Send receive error while getting supported PLDM Types",
@@ -101,7 +98,7 @@ bool getSupportedPLDMTypes(boost::asio::yield_context yield,
 
     uint8_t completionCode;
     rc = decode_get_types_resp(
-        reinterpret_cast<pldm_msg*>(getSupportedPLDMTypesResponse.data()),
+        getSupportedPLDMTypesResponse.msg(),
         getSupportedPLDMTypesResponse.size() - hdrSize, &completionCode,
         supportedTypes.data());
     if (!validateBaseRespDecode(eid, rc, completionCode, "GetTypes"))
@@ -114,14 +111,26 @@ bool getSupportedPLDMTypes(boost::asio::yield_context yield,
     return true;
 }
 
+bool isPldmTypeSupported(const SupportedPLDMTypes& pldmTypes,
+                         const uint8_t pldmType)
+{
+    constexpr uint8_t bitsPerByte = 8;
+    if (pldmType >= PLDM_MAX_TYPES)
+    {
+        return false;
+    }
+    return pldmTypes[pldmType / bitsPerByte].byte &
+           (1 << (pldmType % bitsPerByte));
+}
+
 bool baseInit(boost::asio::yield_context yield, const mctpw_eid_t eid,
-              pldm_tid_t& /*tid*/)
+              const NetworkId network, pldm_tid_t& /*tid*/,
+              SupportedPLDMTypes& pldmTypes)
 {
     phosphor::logging::log<phosphor::logging::level::INFO>(
         "Running Base initialisation", phosphor::logging::entry("EID=%d", eid));
 
-    SupportedPLDMTypes pldmTypes;
-    if (!getSupportedPLDMTypes(yield, eid, pldmTypes))
+    if (!getSupportedPLDMTypes(yield, eid, network, pldmTypes))
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "Error getting supported PLDM Types",
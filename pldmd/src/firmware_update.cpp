@@ -172,10 +172,10 @@ static void
 
 int FWInventoryInfo::runQueryDeviceIdentifiers(boost::asio::yield_context yield)
 {
-    uint8_t instanceID = createInstanceId(tid);
-    std::vector<uint8_t> pldmReq(sizeof(struct PLDMEmptyRequest));
+    uint8_t instanceID = createInstanceId(yield, tid);
+    MessageBuffer pldmReq(sizeof(struct PLDMEmptyRequest));
 
-    struct pldm_msg* msgReq = reinterpret_cast<pldm_msg*>(pldmReq.data());
+    struct pldm_msg* msgReq = pldmReq.msg();
 
     int retVal = encode_query_device_identifiers_req(
         instanceID, msgReq, PLDM_QUERY_DEVICE_IDENTIFIERS_REQ_BYTES);
@@ -189,7 +189,7 @@ int FWInventoryInfo::runQueryDeviceIdentifiers(boost::asio::yield_context yield)
         return retVal;
     }
 
-    std::vector<uint8_t> pldmResp;
+    MessageBuffer pldmResp;
 
     if (!sendReceivePldmMessage(yield, tid, timeout, retryCount, pldmReq,
                                 pldmResp))
@@ -200,7 +200,7 @@ int FWInventoryInfo::runQueryDeviceIdentifiers(boost::asio::yield_context yield)
         return PLDM_ERROR;
     }
 
-    auto msgResp = reinterpret_cast<pldm_msg*>(pldmResp.data());
+    auto msgResp = pldmResp.msg();
 
     size_t payloadLen = pldmResp.size() - hdrSize;
 
@@ -355,10 +355,10 @@ void FWInventoryInfo::unpackCompData(const uint16_t count,
 
 int FWInventoryInfo::runGetFirmwareParameters(boost::asio::yield_context yield)
 {
-    uint8_t instanceID = createInstanceId(tid);
-    std::vector<uint8_t> pldmReq(sizeof(struct PLDMEmptyRequest));
+    uint8_t instanceID = createInstanceId(yield, tid);
+    MessageBuffer pldmReq(sizeof(struct PLDMEmptyRequest));
 
-    struct pldm_msg* msgReq = reinterpret_cast<pldm_msg*>(pldmReq.data());
+    struct pldm_msg* msgReq = pldmReq.msg();
 
     int retVal = encode_get_firmware_parameters_req(
         instanceID, msgReq, PLDM_QUERY_DEVICE_IDENTIFIERS_REQ_BYTES);
@@ -372,7 +372,7 @@ int FWInventoryInfo::runGetFirmwareParameters(boost::asio::yield_context yield)
         return retVal;
     }
 
-    std::vector<uint8_t> pldmResp;
+    MessageBuffer pldmResp;
 
     if (!sendReceivePldmMessage(yield, tid, timeout, retryCount, pldmReq,
                                 pldmResp))
@@ -389,7 +389,7 @@ int FWInventoryInfo::runGetFirmwareParameters(boost::asio::yield_context yield)
             "GetFirmwareParameters: Response lenght is invalid");
         return PLDM_ERROR_INVALID_LENGTH;
     }
-    auto respMsg = reinterpret_cast<pldm_msg*>(pldmResp.data());
+    auto respMsg = pldmResp.msg();
     size_t payloadLen = pldmResp.size() - hdrSize;
 
     struct get_firmware_parameters_resp resp;
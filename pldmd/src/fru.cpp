@@ -31,10 +31,10 @@ constexpr size_t hdrSize = sizeof(pldm_msg_hdr);
 
 int PLDMFRUCmd::getFRURecordTableMetadataCmd()
 {
-    uint8_t instanceID = createInstanceId(tid);
+    uint8_t instanceID = createInstanceId(yield, tid);
 
-    std::vector<uint8_t> requestMsg(sizeof(PLDMEmptyRequest));
-    struct pldm_msg* request = reinterpret_cast<pldm_msg*>(requestMsg.data());
+    MessageBuffer requestMsg(sizeof(PLDMEmptyRequest));
+    struct pldm_msg* request = requestMsg.msg();
 
     int rc = encode_get_fru_record_table_metadata_req(
         instanceID, request, PLDM_GET_FRU_RECORD_TABLE_METADATA_REQ_BYTES);
@@ -44,7 +44,7 @@ int PLDMFRUCmd::getFRURecordTableMetadataCmd()
         return PLDM_ERROR;
     }
 
-    std::vector<uint8_t> responseMsg;
+    MessageBuffer responseMsg;
 
     if (!sendReceivePldmMessage(yield, tid, timeout, retryCount, requestMsg,
                                 responseMsg))
@@ -55,7 +55,7 @@ int PLDMFRUCmd::getFRURecordTableMetadataCmd()
         return PLDM_ERROR;
     }
 
-    auto responsePtr = reinterpret_cast<pldm_msg*>(responseMsg.data());
+    auto responsePtr = responseMsg.msg();
     size_t payloadLen = responseMsg.size() - hdrSize;
 
     // parse response
@@ -0,0 +1,82 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "message_buffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace pldm
+{
+
+// Buffers kept for reuse, enough for every terminus initialised in parallel
+static constexpr size_t maxPooledBuffers = 64;
+static std::vector<std::vector<uint8_t>> bufferPool;
+
+MessageBuffer::MessageBuffer(const size_t size)
+{
+    if (!bufferPool.empty())
+    {
+        storage = std::move(bufferPool.back());
+        bufferPool.pop_back();
+    }
+    storage.resize(headroom + size);
+}
+
+MessageBuffer::~MessageBuffer()
+{
+    if (storage.capacity() != 0 && bufferPool.size() < maxPooledBuffers)
+    {
+        storage.clear();
+        bufferPool.push_back(std::move(storage));
+    }
+}
+
+MessageBuffer::MessageBuffer(MessageBuffer&& other) noexcept :
+    storage(std::move(other.storage)), head(other.head)
+{
+    other.storage.clear();
+    other.head = 0;
+}
+
+MessageBuffer& MessageBuffer::operator=(MessageBuffer&& other) noexcept
+{
+    std::swap(storage, other.storage);
+    std::swap(head, other.head);
+    return *this;
+}
+
+void MessageBuffer::assign(const uint8_t* src, const size_t size)
+{
+    head = headroom;
+    storage.resize(head + size);
+    std::copy(src, src + size, data());
+}
+
+void MessageBuffer::pushFront(const uint8_t value)
+{
+    if (head == 0)
+    {
+        throw std::length_error("PLDM message buffer headroom exhausted");
+    }
+    storage[--head] = value;
+}
+
+void MessageBuffer::popFront(const size_t count)
+{
+    head += std::min(count, size());
+}
+
+} // namespace pldm
@@ -0,0 +1,71 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pldm.hpp"
+
+#include "command_metrics.hpp"
+
+#include <map>
+#include <tuple>
+
+namespace pldm
+{
+namespace metrics
+{
+
+static constexpr const char* metricsPath = "/xyz/openbmc_project/pldm";
+static constexpr const char* metricsInterface =
+    "xyz.openbmc_project.PLDM.Metrics";
+
+// Keyed by network, EID, PLDM type and command
+using CommandKey = std::tuple<NetworkId, mctpw_eid_t, uint8_t, uint8_t>;
+static std::map<CommandKey, CommandMetrics> commands;
+
+void record(const transport::Endpoint& endpoint, const uint8_t pldmType,
+            const uint8_t command, const bool success, const size_t retries,
+            const std::chrono::microseconds latency)
+{
+    commands[std::make_tuple(endpoint.network, endpoint.eid, pldmType,
+                             command)]
+        .record(success, retries, latency);
+}
+
+void registerInterface()
+{
+    auto objServer = getObjServer();
+    auto iface = objServer->add_interface(metricsPath, metricsInterface);
+    iface->register_property("LatencyBucketsUs", latencyBuckets);
+    // Network, EID, type, command, count, failures, retries, total
+    // latency(us), histogram with one entry per bucket plus overflow bucket
+    iface->register_method("GetCommandMetrics", []() {
+        std::vector<
+            std::tuple<uint8_t, uint8_t, uint8_t, uint8_t, uint32_t, uint32_t,
+                       uint32_t, uint64_t, std::vector<uint32_t>>>
+            result;
+        for (const auto& [key, entry] : commands)
+        {
+            result.emplace_back(std::get<0>(key), std::get<1>(key),
+                                std::get<2>(key), std::get<3>(key),
+                                entry.count, entry.failures, entry.retries,
+                                entry.totalLatency, entry.histogram);
+        }
+        return result;
+    });
+    iface->register_method("Reset", []() { commands.clear(); });
+    iface->initialize();
+}
+
+} // namespace metrics
+} // namespace pldm
@@ -19,14 +19,36 @@
 #include "platform.hpp"
 #include "pldm.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <endian.h>
+#include <limits>
 #include <phosphor-logging/log.hpp>
 
+#include "utils.h"
+
 namespace pldm
 {
 namespace platform
 {
 
-PDRManager::PDRManager(const pldm_tid_t tid) : _tid(tid)
+// Response carries MCTP type, PLDM header, GetPDR fields and transfer CRC
+// besides record data
+static constexpr size_t getPDRRespOverhead =
+    1 + pldmMsgHdrSize + PLDM_GET_PDR_MIN_RESP_BYTES + 1;
+static constexpr size_t maxPDRSize =
+    sizeof(pldm_pdr_hdr) + std::numeric_limits<uint16_t>::max();
+
+// sensorInit value of sensor PDRs(DSP0248) keeping the sensor disabled
+static constexpr uint8_t sensorInitDisable = 3;
+// Polling interval limits, State Sensor PDR does not define update interval
+static constexpr std::chrono::milliseconds defaultPollInterval(1000);
+static constexpr std::chrono::milliseconds minPollInterval(100);
+static constexpr std::chrono::milliseconds maxPollInterval(60000);
+
+PDRManager::PDRManager(const pldm_tid_t tid) :
+    _tid(tid), _pdrRepo(pldm_pdr_init(), pldm_pdr_destroy)
 {
 }
 
@@ -34,16 +56,17 @@ std::optional<pldm_pdr_repository_info>
     PDRManager::getPDRRepositoryInfo(boost::asio::yield_context& yield)
 {
     int rc;
-    std::vector<uint8_t> req(sizeof(PLDMEmptyRequest));
-    pldm_msg* reqMsg = reinterpret_cast<pldm_msg*>(req.data());
+    MessageBuffer req(sizeof(PLDMEmptyRequest));
+    pldm_msg* reqMsg = req.msg();
 
-    rc = encode_get_pdr_repository_info_req(createInstanceId(_tid), reqMsg);
+    rc = encode_get_pdr_repository_info_req(createInstanceId(yield, _tid),
+                                            reqMsg);
     if (!validatePLDMReqEncode(_tid, rc, "GetPDRRepositoryInfo"))
     {
         return std::nullopt;
     }
 
-    std::vector<uint8_t> resp;
+    MessageBuffer resp;
     if (!sendReceivePldmMessage(yield, _tid, commandTimeout, commandRetryCount,
                                 req, resp))
     {
@@ -54,7 +77,7 @@ std::optional<pldm_pdr_repository_info>
     }
 
     pldm_get_pdr_repository_info_resp pdrInfo;
-    auto rspMsg = reinterpret_cast<pldm_msg*>(resp.data());
+    auto rspMsg = resp.msg();
 
     rc = decode_get_pdr_repository_info_resp(
         rspMsg, resp.size() - pldmMsgHdrSize, &pdrInfo);
@@ -70,6 +93,174 @@ std::optional<pldm_pdr_repository_info>
     return pdrInfo.pdr_repo_info;
 }
 
+std::optional<uint32_t>
+    PDRManager::getPDR(boost::asio::yield_context& yield,
+                       const uint32_t recordHandle,
+                       const uint16_t requestCount,
+                       std::vector<uint8_t>& record)
+{
+    MessageBuffer req(pldmMsgHdrSize + PLDM_GET_PDR_REQ_BYTES);
+    MessageBuffer resp;
+    uint32_t dataTransferHandle = 0;
+    uint8_t transferOperation = PLDM_GET_FIRSTPART;
+    uint16_t recordChangeNumber = 0;
+    uint32_t nextRecordHandle = 0;
+
+    record.clear();
+    while (true)
+    {
+        int rc = encode_get_pdr_req(createInstanceId(yield, _tid), recordHandle,
+                                    dataTransferHandle, transferOperation,
+                                    requestCount, recordChangeNumber,
+                                    req.msg(), PLDM_GET_PDR_REQ_BYTES);
+        if (!validatePLDMReqEncode(_tid, rc, "GetPDR"))
+        {
+            return std::nullopt;
+        }
+
+        if (!sendReceivePldmMessage(yield, _tid, commandTimeout,
+                                    commandRetryCount, req, resp))
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Failed to send GetPDR request",
+                phosphor::logging::entry("TID=%d", _tid),
+                phosphor::logging::entry("RECORD_HANDLE=%u", recordHandle));
+            return std::nullopt;
+        }
+
+        // Record data is appended straight from the response
+        uint8_t completionCode;
+        uint32_t nextDataTransferHandle;
+        uint8_t transferFlag;
+        uint16_t respCount;
+        uint8_t transferCRC = 0;
+        rc = decode_get_pdr_resp(resp.msg(), resp.size() - pldmMsgHdrSize,
+                                 &completionCode, &nextRecordHandle,
+                                 &nextDataTransferHandle, &transferFlag,
+                                 &respCount, nullptr, 0, &transferCRC);
+        if (!validatePLDMRespDecode(_tid, rc, completionCode, "GetPDR"))
+        {
+            return std::nullopt;
+        }
+        if (respCount == 0 || record.size() + respCount > maxPDRSize)
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "GetPDR: Invalid record data length",
+                phosphor::logging::entry("TID=%d", _tid),
+                phosphor::logging::entry("RECORD_HANDLE=%u", recordHandle));
+            return std::nullopt;
+        }
+        const uint8_t* recordData =
+            resp.msg()->payload + PLDM_GET_PDR_MIN_RESP_BYTES;
+        record.insert(record.end(), recordData, recordData + respCount);
+
+        if (transferFlag == PLDM_START_AND_END)
+        {
+            break;
+        }
+        if (transferFlag == PLDM_END)
+        {
+            if (crc8(record.data(), record.size()) != transferCRC)
+            {
+                phosphor::logging::log<phosphor::logging::level::ERR>(
+                    "GetPDR: Transfer CRC mismatch",
+                    phosphor::logging::entry("TID=%d", _tid),
+                    phosphor::logging::entry("RECORD_HANDLE=%u",
+                                             recordHandle));
+                return std::nullopt;
+            }
+            break;
+        }
+
+        // Following parts are requested with change number of the record
+        if (transferOperation == PLDM_GET_FIRSTPART &&
+            record.size() >= sizeof(pldm_pdr_hdr))
+        {
+            auto hdr = reinterpret_cast<const pldm_pdr_hdr*>(record.data());
+            recordChangeNumber = le16toh(hdr->record_change_num);
+        }
+        dataTransferHandle = nextDataTransferHandle;
+        transferOperation = PLDM_GET_NEXTPART;
+    }
+
+    auto hdr = reinterpret_cast<const pldm_pdr_hdr*>(record.data());
+    if (record.size() < sizeof(pldm_pdr_hdr) ||
+        record.size() != sizeof(pldm_pdr_hdr) + le16toh(hdr->length))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "GetPDR: Record length mismatch",
+            phosphor::logging::entry("TID=%d", _tid),
+            phosphor::logging::entry("RECORD_HANDLE=%u", recordHandle));
+        return std::nullopt;
+    }
+    pldm_pdr_add(_pdrRepo.get(), record.data(),
+                 static_cast<uint32_t>(record.size()),
+                 le32toh(hdr->record_handle), true);
+    return nextRecordHandle;
+}
+
+// Largest record part a response from the terminus can carry, bound by the
+// message size its MCTP binding reassembles
+static uint16_t getMaxPDRTransferSize(const pldm_tid_t tid)
+{
+    size_t maxMessageSize = transport::defaultMaxMessageSize;
+    if (auto endpoint = getEndpointFromMapper(tid))
+    {
+        maxMessageSize = transport::getMaxMessageSize(endpoint->network);
+    }
+    if (maxMessageSize <= getPDRRespOverhead)
+    {
+        return 1;
+    }
+    return static_cast<uint16_t>(
+        std::min<size_t>(maxMessageSize - getPDRRespOverhead,
+                         std::numeric_limits<uint16_t>::max()));
+}
+
+bool PDRManager::getPDRs(boost::asio::yield_context& yield)
+{
+    // Ask for whole records so that each one takes single round trip when
+    // the binding allows it
+    uint16_t requestCount = getMaxPDRTransferSize(_tid);
+    if (pdrRepoInfo.largest_record_size > 0 &&
+        pdrRepoInfo.largest_record_size < requestCount)
+    {
+        requestCount = static_cast<uint16_t>(pdrRepoInfo.largest_record_size);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> record;
+    record.reserve(requestCount);
+    // Record handle 0 requests the first record, 0 as next handle marks the
+    // last one. Handle already fetched means the repository loops.
+    uint32_t recordHandle = 0;
+    uint8_t* data = nullptr;
+    uint32_t size = 0;
+    uint32_t nextHandle = 0;
+    do
+    {
+        auto nextRecordHandle =
+            getPDR(yield, recordHandle, requestCount, record);
+        if (!nextRecordHandle)
+        {
+            return false;
+        }
+        recordHandle = *nextRecordHandle;
+    } while (recordHandle != 0 &&
+             !pldm_pdr_find_record(_pdrRepo.get(), recordHandle, &data, &size,
+                                   &nextHandle));
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "PDRs fetched", phosphor::logging::entry("TID=%d", _tid),
+        phosphor::logging::entry("RECORD_COUNT=%u",
+                                 pldm_pdr_get_record_count(_pdrRepo.get())),
+        phosphor::logging::entry("DURATION_MS=%lld",
+                                 static_cast<long long>(duration.count())));
+    return true;
+}
+
 bool PDRManager::pdrManagerInit(boost::asio::yield_context& yield)
 {
     std::optional<pldm_pdr_repository_info> pdrInfo =
@@ -80,8 +271,81 @@ bool PDRManager::pdrManagerInit(boost::asio::yield_context& yield)
     }
     pdrRepoInfo = *pdrInfo;
 
-    // TODO: Get the PDR and parse
-    return true;
+    return getPDRs(yield);
+}
+
+static std::chrono::milliseconds getPollInterval(const real32_t updateInterval)
+{
+    if (!std::isfinite(updateInterval) || updateInterval <= 0)
+    {
+        return defaultPollInterval;
+    }
+    auto interval = std::chrono::milliseconds(
+        static_cast<std::chrono::milliseconds::rep>(std::min(
+            updateInterval * 1000.0f,
+            static_cast<float>(maxPollInterval.count()))));
+    return std::clamp(interval, minPollInterval, maxPollInterval);
+}
+
+std::vector<Sensor> PDRManager::getSensors() const
+{
+    std::vector<Sensor> sensors;
+    uint8_t* data = nullptr;
+    uint32_t size = 0;
+
+    const pldm_pdr_record* record = nullptr;
+    while ((record = pldm_pdr_find_record_by_type(
+                _pdrRepo.get(), PLDM_NUMERIC_SENSOR_PDR, record, &data,
+                &size)) != nullptr)
+    {
+        pldm_numeric_sensor_value_pdr pdr;
+        if (size > std::numeric_limits<uint16_t>::max() ||
+            !pldm_numeric_sensor_pdr_parse(data, static_cast<uint16_t>(size),
+                                           reinterpret_cast<uint8_t*>(&pdr)))
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Invalid Numeric Sensor PDR",
+                phosphor::logging::entry("TID=%d", _tid));
+            continue;
+        }
+        if (pdr.sensor_init == sensorInitDisable)
+        {
+            continue;
+        }
+        Sensor sensor{};
+        sensor.id = pdr.sensor_id;
+        sensor.type = Sensor::Type::numeric;
+        sensor.interval = getPollInterval(pdr.update_interval);
+        sensor.resolution = pdr.resolution;
+        sensor.offset = pdr.offset;
+        sensor.unitModifier = pdr.unit_modifier;
+        sensors.push_back(sensor);
+    }
+
+    while ((record = pldm_pdr_find_record_by_type(
+                _pdrRepo.get(), PLDM_STATE_SENSOR_PDR, record, &data,
+                &size)) != nullptr)
+    {
+        if (size < sizeof(pldm_state_sensor_pdr))
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Invalid State Sensor PDR",
+                phosphor::logging::entry("TID=%d", _tid));
+            continue;
+        }
+        auto pdr = reinterpret_cast<const pldm_state_sensor_pdr*>(data);
+        if (pdr->sensor_init == sensorInitDisable)
+        {
+            continue;
+        }
+        Sensor sensor{};
+        sensor.id = le16toh(pdr->sensor_id);
+        sensor.type = Sensor::Type::state;
+        sensor.compositeCount = pdr->composite_sensor_count;
+        sensor.interval = defaultPollInterval;
+        sensors.push_back(sensor);
+    }
+    return sensors;
 }
 
 } // namespace platform
@@ -16,6 +16,7 @@
 #include "platform.hpp"
 
 #include "pldm.hpp"
+#include "sensor_poller.hpp"
 
 #include <phosphor-logging/log.hpp>
 
@@ -49,6 +50,8 @@ bool platformInit(boost::asio::yield_context yield, const pldm_tid_t tid,
     phosphor::logging::log<phosphor::logging::level::INFO>(
         "PDR Manager Init Success", phosphor::logging::entry("TID=0x%X", tid));
 
+    startSensorPolling(tid, platformMC.pdrManager->getSensors());
+
     return true;
 }
 
@@ -63,6 +66,7 @@ bool platformDestroy(const pldm_tid_t tid)
                 .c_str());
         return false;
     }
+    stopSensorPolling(tid);
     platforms.erase(entry);
     phosphor::logging::log<phosphor::logging::level::INFO>(
         ("Platform Monitoring and Control resources destroyed for TID " +
@@ -71,5 +75,143 @@ bool platformDestroy(const pldm_tid_t tid)
 
     return true;
 }
+static std::optional<SensorEvent> decodeSensorEvent(const uint8_t* eventData,
+                                                    const size_t length)
+{
+    SensorEvent event{};
+    size_t classDataOffset = 0;
+    int rc = decode_sensor_event_data(eventData, length, &event.sensorId,
+                                      &event.eventClass, &classDataOffset);
+    if (rc != PLDM_SUCCESS || classDataOffset > length)
+    {
+        return std::nullopt;
+    }
+
+    const uint8_t* classData = eventData + classDataOffset;
+    size_t classDataLength = length - classDataOffset;
+    uint8_t previousState;
+    switch (event.eventClass)
+    {
+        case PLDM_SENSOR_OP_STATE:
+            rc = decode_sensor_op_data(classData, classDataLength,
+                                       &event.operationalState,
+                                       &previousState);
+            break;
+        case PLDM_STATE_SENSOR_STATE:
+            rc = decode_state_sensor_data(classData, classDataLength,
+                                          &event.sensorOffset, &event.state,
+                                          &previousState);
+            break;
+        case PLDM_NUMERIC_SENSOR_STATE:
+        {
+            uint8_t eventState;
+            rc = decode_numeric_sensor_data(
+                classData, classDataLength, &eventState, &previousState,
+                &event.dataSize, &event.presentReading);
+            break;
+        }
+        default:
+            rc = PLDM_ERROR_INVALID_DATA;
+            break;
+    }
+    if (rc != PLDM_SUCCESS)
+    {
+        return std::nullopt;
+    }
+    return event;
+}
+
+// Returns completion code for the event
+static uint8_t handlePlatformEvent(const pldm_tid_t tid,
+                                   std::vector<uint8_t>& message)
+{
+    uint8_t formatVersion;
+    uint8_t eventTid;
+    uint8_t eventClass;
+    size_t eventDataOffset;
+    auto msg = reinterpret_cast<const pldm_msg*>(message.data());
+    size_t payloadLength = message.size() - pldmMsgHdrSize;
+    int rc = decode_platform_event_message_req(msg, payloadLength,
+                                               &formatVersion, &eventTid,
+                                               &eventClass, &eventDataOffset);
+    if (rc != PLDM_SUCCESS || eventDataOffset > payloadLength)
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "Invalid PlatformEventMessage",
+            phosphor::logging::entry("TID=%d", tid),
+            phosphor::logging::entry("RC=%d", rc));
+        return PLDM_ERROR_INVALID_DATA;
+    }
+
+    // Other event classes are acknowledged and dropped
+    if (eventClass != PLDM_SENSOR_EVENT)
+    {
+        phosphor::logging::log<phosphor::logging::level::DEBUG>(
+            "Unhandled PLDM event class",
+            phosphor::logging::entry("TID=%d", tid),
+            phosphor::logging::entry("EVENT_CLASS=%d", eventClass));
+        return PLDM_SUCCESS;
+    }
+
+    auto event = decodeSensorEvent(msg->payload + eventDataOffset,
+                                   payloadLength - eventDataOffset);
+    if (!event)
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "Invalid sensor event data",
+            phosphor::logging::entry("TID=%d", tid));
+        return PLDM_ERROR_INVALID_DATA;
+    }
+    if (!onSensorEvent(tid, *event))
+    {
+        phosphor::logging::log<phosphor::logging::level::DEBUG>(
+            "Event for unknown sensor",
+            phosphor::logging::entry("TID=%d", tid),
+            phosphor::logging::entry("SENSOR_ID=%d", event->sensorId));
+    }
+    return PLDM_SUCCESS;
+}
+
+void pldmMsgRecvCallback(const pldm_tid_t tid, const uint8_t msgTag,
+                         const bool tagOwner, std::vector<uint8_t>& message)
+{
+    // Only requests are expected, responses are received by the requester
+    auto msg = reinterpret_cast<const pldm_msg*>(message.data());
+    if (!tagOwner || message.size() < pldmMsgHdrSize || !msg->hdr.request ||
+        msg->hdr.datagram)
+    {
+        return;
+    }
+    uint8_t instanceId = msg->hdr.instance_id;
+
+    std::vector<uint8_t> response;
+    int rc;
+    if (msg->hdr.command == PLDM_PLATFORM_EVENT_MESSAGE)
+    {
+        uint8_t completionCode = handlePlatformEvent(tid, message);
+        response.resize(pldmMsgHdrSize +
+                        PLDM_PLATFORM_EVENT_MESSAGE_RESP_BYTES);
+        rc = encode_platform_event_message_resp(
+            instanceId, completionCode, PLDM_EVENT_NO_LOGGING,
+            reinterpret_cast<pldm_msg*>(response.data()));
+    }
+    else
+    {
+        response.resize(pldmMsgHdrSize + sizeof(pldm_cc_only_rsp));
+        rc = encode_cc_only_resp(instanceId, PLDM_PLATFORM, msg->hdr.command,
+                                 PLDM_ERROR_UNSUPPORTED_PLDM_CMD,
+                                 reinterpret_cast<pldm_msg*>(response.data()));
+    }
+    if (rc != PLDM_SUCCESS)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to encode Platform response",
+            phosphor::logging::entry("TID=%d", tid),
+            phosphor::logging::entry("RC=%d", rc));
+        return;
+    }
+    sendPldmMessage(tid, msgTag, false, response);
+}
+
 } // namespace platform
 } // namespace pldm
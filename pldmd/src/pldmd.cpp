@@ -16,67 +16,122 @@
 
 #include "pldm.hpp"
 
+#include "instance_id.hpp"
+#include "sensor_poller.hpp"
+#include "tid_mapper.hpp"
+
+#include <algorithm>
+#include <boost/asio/steady_timer.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <map>
 #include <phosphor-logging/log.hpp>
+#include <set>
+#include <stdexcept>
+
+#include "fru.h"
+#include "platform.h"
 
 static constexpr const char* pldmService = "xyz.openbmc_project.pldm";
 static constexpr const char* pldmPath = "/xyz/openbmc_project/pldm";
 
+// Number of termini initialised at the same time
+static constexpr size_t maxParallelInit = PLDM_INIT_CONCURRENCY;
+
 namespace pldm
 {
-// Mapper will have 1:1 mapping between TID and EID
-using Mapper = std::unordered_map<
-    pldm_tid_t, /*TID as key*/
-    mctpw_eid_t /*TODO: Update to std::variant<MCTP_EID, RBT for NCSI) etc.*/>;
-static Mapper tidMapper;
+static TidMapper mapper;
 
-std::optional<pldm_tid_t> getTidFromMapper(const mctpw_eid_t eid)
+std::optional<pldm_tid_t> getTidFromMapper(const mctpw_eid_t eid,
+                                           const NetworkId network)
 {
-    for (auto& eidMap : tidMapper)
+    if (auto tid = mapper.getTid(transport::Endpoint{network, eid}))
     {
-        if (eidMap.second == eid)
-        {
-            return eidMap.second;
-        }
+        return tid;
     }
     phosphor::logging::log<phosphor::logging::level::WARNING>(
-        "EID not found in the mapper");
+        "EID not found in the mapper", phosphor::logging::entry("EID=%d", eid),
+        phosphor::logging::entry("NETWORK=%d", network));
     return std::nullopt;
 }
 
-void addToMapper(const pldm_tid_t tid, const mctpw_eid_t eid)
+void removeFromMapper(const pldm_tid_t tid)
+{
+    mapper.remove(tid);
+}
+
+void addToMapper(const pldm_tid_t tid, const mctpw_eid_t eid,
+                 const NetworkId network)
 {
-    tidMapper[tid] = eid;
+    // EID can be mapped to one TID only
+    mapper.add(tid, transport::Endpoint{network, eid});
     phosphor::logging::log<phosphor::logging::level::INFO>(
         ("Mapper: TID " + std::to_string(static_cast<int>(tid)) +
-         " mapped to EID " + std::to_string(static_cast<int>(eid)))
+         " mapped to EID " + std::to_string(static_cast<int>(eid)) +
+         " on network " + std::to_string(static_cast<int>(network)))
             .c_str());
 }
 
+// TIDs released by removed termini are reused round robin, so the one just
+// released is handed out last. TID 0xFF is reserved.
 std::optional<pldm_tid_t> getFreeTid()
 {
-    static pldm_tid_t tid = 0x00;
-    if (tid < PLDM_TID_MAX)
+    constexpr pldm_tid_t maxTid = PLDM_TID_MAX - 1;
+    static pldm_tid_t lastTid = 0x00;
+    for (pldm_tid_t i = 0; i < maxTid; i++)
     {
-        tid += 1;
-        return tid;
+        lastTid = static_cast<pldm_tid_t>(lastTid % maxTid + 1);
+        if (mapper.isFree(lastTid))
+        {
+            return lastTid;
+        }
     }
     phosphor::logging::log<phosphor::logging::level::ERR>(
         "No free TID available");
     return std::nullopt;
 }
 
-std::optional<mctpw_eid_t> getEidFromMapper(const pldm_tid_t tid)
+std::optional<transport::Endpoint> getEndpointFromMapper(const pldm_tid_t tid)
 {
-    auto mapperPtr = tidMapper.find(tid);
-    if (mapperPtr != tidMapper.end())
+    if (auto endpoint = mapper.getEndpoint(tid))
     {
-        return mapperPtr->second;
+        return endpoint;
     }
     phosphor::logging::log<phosphor::logging::level::WARNING>(
         "TID not found in the mapper");
     return std::nullopt;
 }
 
+std::optional<mctpw_eid_t> getEidFromMapper(const pldm_tid_t tid)
+{
+    if (auto endpoint = getEndpointFromMapper(tid))
+    {
+        return endpoint->eid;
+    }
+    return std::nullopt;
+}
+
+uint32_t getMapperGeneration()
+{
+    return mapper.getGeneration();
+}
+
+void removeTerminus(const transport::Endpoint& endpoint)
+{
+    auto tid = mapper.getTid(endpoint);
+    if (!tid)
+    {
+        return;
+    }
+    platform::platformDestroy(*tid);
+    removeFromMapper(*tid);
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "PLDM terminus removed", phosphor::logging::entry("TID=%d", *tid),
+        phosphor::logging::entry("EID=%d", endpoint.eid),
+        phosphor::logging::entry("NETWORK=%d", endpoint.network));
+}
+
 std::optional<uint8_t> getInstanceId(std::vector<uint8_t>& message)
 {
     if (message.empty())
@@ -150,52 +205,208 @@ bool validatePLDMRespDecode(const pldm_tid_t tid, const int rc,
     return true;
 }
 
-static inline void printVect(const std::string& msg,
-                             const std::vector<uint8_t>& vec)
+// Message dumps are formatted only when enabled by PLDM_TRACES=1
+static bool tracesEnabled = false;
+
+static void initializeLogging()
+{
+    if (auto envPtr = std::getenv("PLDM_TRACES"))
+    {
+        std::string value(envPtr);
+        if (value == "1")
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "PLDM traces enabled, expect lower performance");
+            tracesEnabled = true;
+        }
+    }
+}
+
+static inline void printVect(const std::string& msg, const uint8_t* data,
+                             const size_t size)
 {
+    if (!tracesEnabled)
+    {
+        return;
+    }
     phosphor::logging::log<phosphor::logging::level::DEBUG>(
-        ("Length:" + std::to_string(vec.size())).c_str());
+        ("Length:" + std::to_string(size)).c_str());
 
     std::stringstream ssVec;
     ssVec << msg;
-    for (auto re : vec)
+    for (size_t i = 0; i < size; i++)
     {
         ssVec << " 0x" << std::hex << std::setfill('0') << std::setw(2)
-              << static_cast<int>(re);
+              << static_cast<int>(data[i]);
     }
     phosphor::logging::log<phosphor::logging::level::DEBUG>(
         ssVec.str().c_str());
 }
 
+// Instance IDs belong to requester and responder pair, so they are tracked
+// per endpoint whether the request is addressed by TID or by EID
+static InstanceIdAllocator&
+    getInstanceIdAllocator(const transport::Endpoint& endpoint)
+{
+    static std::map<std::pair<NetworkId, mctpw_eid_t>,
+                    std::unique_ptr<InstanceIdAllocator>>
+        allocators;
+
+    auto& allocator =
+        allocators[std::make_pair(endpoint.network, endpoint.eid)];
+    if (!allocator)
+    {
+        allocator = std::make_unique<InstanceIdAllocator>(*getIoContext());
+    }
+    return *allocator;
+}
+
+// Request to unmapped TID fails anyway, its IDs are taken from null EID
+static transport::Endpoint getRequestEndpoint(const pldm_tid_t tid,
+                                              std::optional<mctpw_eid_t> eid,
+                                              const NetworkId network)
+{
+    if (eid)
+    {
+        return transport::Endpoint{network, *eid};
+    }
+    return getEndpointFromMapper(tid).value_or(transport::Endpoint{0, 0});
+}
+
+// Read-only commands, mctpd may answer them with the response of an identical
+// request from another client which is already in flight
+static bool isIdempotentCommand(const MessageBuffer& pldmReq)
+{
+    constexpr size_t mctpMsgTypeSize = 1;
+    auto hdr =
+        reinterpret_cast<const pldm_msg_hdr*>(pldmReq.data() + mctpMsgTypeSize);
+    switch (hdr->type)
+    {
+        case PLDM_BASE:
+            return hdr->command == PLDM_GET_TID ||
+                   hdr->command == PLDM_GET_PLDM_VERSION ||
+                   hdr->command == PLDM_GET_PLDM_TYPES ||
+                   hdr->command == PLDM_GET_PLDM_COMMANDS;
+        case PLDM_PLATFORM:
+            return hdr->command == PLDM_GET_SENSOR_READING ||
+                   hdr->command == PLDM_GET_STATE_SENSOR_READINGS ||
+                   hdr->command == PLDM_GET_NUMERIC_EFFECTER_VALUE ||
+                   hdr->command == PLDM_GET_STATE_EFFECTER_STATES ||
+                   hdr->command == PLDM_GET_PDR_REPOSITORY_INFO ||
+                   hdr->command == PLDM_GET_PDR;
+        case PLDM_FRU:
+            return hdr->command == PLDM_GET_FRU_RECORD_TABLE_METADATA ||
+                   hdr->command == PLDM_GET_FRU_RECORD_TABLE;
+        default:
+            return false;
+    }
+}
+
+// MCTP services without the idempotent method(mctpd built without request
+// coalescing, mctp_emulator) get plain requests once it was found missing
+static std::set<std::string> plainRequestServices;
+
+static bool isUnknownMethod(sdbusplus::message::message& response)
+{
+    return response.get() != nullptr &&
+           sd_bus_message_is_method_error(
+               response.get(), "org.freedesktop.DBus.Error.UnknownMethod") > 0;
+}
+
+// Payload is passed to and from D-Bus message directly, without intermediate
+// vectors
 static bool doSendReceievePldmMessage(boost::asio::yield_context yield,
-                                      const mctpw_eid_t dstEid,
+                                      const transport::Endpoint& dst,
                                       const uint16_t timeout,
-                                      std::vector<uint8_t>& pldmReq,
-                                      std::vector<uint8_t>& pldmResp)
+                                      const MessageBuffer& pldmReq,
+                                      MessageBuffer& pldmResp)
 {
     // TODO: Use mctp-wrapper provided api to send/receive PLDM message
-    boost::system::error_code ec;
+    const mctpw_eid_t dstEid = dst.eid;
+    auto service = transport::getMctpService(dst.network, dstEid);
+    if (!service)
+    {
+        return false;
+    }
     auto bus = getSdBus();
-    pldmResp = bus->yield_method_call<std::vector<uint8_t>>(
-        yield, ec, "xyz.openbmc_project.MCTP_SMBus_PCIe_slot",
-        "/xyz/openbmc_project/mctp", "xyz.openbmc_project.MCTP.Base",
-        "SendReceiveMctpMessagePayload", dstEid, pldmReq, timeout);
-    printVect("Request(MCTP payload):", pldmReq);
-    printVect("Response(MCTP payload):", pldmResp);
-    if (ec)
+    const bool idempotent = isIdempotentCommand(pldmReq) &&
+                            plainRequestServices.count(*service) == 0;
+    auto request = bus->new_method_call(
+        service->c_str(), "/xyz/openbmc_project/mctp",
+        "xyz.openbmc_project.MCTP.Base",
+        idempotent ? "SendReceiveIdempotentMctpMessagePayload"
+                   : "SendReceiveMctpMessagePayload");
+    request.append(dstEid);
+    int rc = sd_bus_message_append_array(request.get(), 'y', pldmReq.data(),
+                                         pldmReq.size());
+    if (rc < 0)
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "Failed to build PLDM request message",
+            phosphor::logging::entry("RC=%d", rc));
+        return false;
+    }
+    auto responseTimeout =
+        rtt::getTimeout(dst, std::chrono::milliseconds(timeout));
+    request.append(static_cast<uint16_t>(responseTimeout.count()));
+
+    boost::system::error_code ec;
+    auto sendTime = std::chrono::steady_clock::now();
+    auto response = bus->async_send(request, yield[ec]);
+    printVect("Request(MCTP payload):", pldmReq.data(), pldmReq.size());
+    if (idempotent && isUnknownMethod(response))
+    {
+        phosphor::logging::log<phosphor::logging::level::INFO>(
+            "MCTP service has no idempotent send/receive, using plain one",
+            phosphor::logging::entry("SERVICE=%s", service->c_str()));
+        plainRequestServices.insert(*service);
+        return doSendReceievePldmMessage(yield, dst, timeout, pldmReq,
+                                         pldmResp);
+    }
+    if (ec || response.is_method_error())
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "PLDM message send/receive failed",
+            phosphor::logging::entry("EID=%d", dstEid),
+            phosphor::logging::entry(
+                "TIMEOUT_MS=%d", static_cast<int>(responseTimeout.count())));
+        // Other failures(no route, bad request) say nothing about the RTT
+        if (ec == boost::system::errc::timed_out ||
+            (!ec && response.is_method_error() &&
+             sd_bus_message_get_errno(response.get()) == ETIMEDOUT))
+        {
+            rtt::onTimeout(dst);
+        }
+        return false;
+    }
+    rtt::addSample(dst,
+                   std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - sendTime));
+
+    const void* payload = nullptr;
+    size_t payloadSize = 0;
+    rc = sd_bus_message_read_array(response.get(), 'y', &payload,
+                                   &payloadSize);
+    if (rc < 0)
     {
         phosphor::logging::log<phosphor::logging::level::WARNING>(
-            "PLDM message send/receive failed");
+            "Failed to read PLDM response message",
+            phosphor::logging::entry("RC=%d", rc));
         return false;
     }
+    pldmResp.assign(static_cast<const uint8_t*>(payload), payloadSize);
+    printVect("Response(MCTP payload):", pldmResp.data(), pldmResp.size());
     return true;
 }
 
-bool sendReceivePldmMessage(boost::asio::yield_context yield,
-                            const pldm_tid_t tid, const uint16_t timeout,
-                            size_t retryCount, std::vector<uint8_t> pldmReq,
-                            std::vector<uint8_t>& pldmResp,
-                            std::optional<mctpw_eid_t> eid)
+// Request carries MCTP message type, response is returned without it
+static bool sendReceiveWithRetry(boost::asio::yield_context yield,
+                                 const pldm_tid_t tid, const uint16_t timeout,
+                                 size_t retryCount,
+                                 const MessageBuffer& pldmReq,
+                                 MessageBuffer& pldmResp,
+                                 std::optional<mctpw_eid_t> eid,
+                                 const NetworkId network, size_t& attempts)
 {
     // Retry the request if
     //  1) No response
@@ -211,23 +422,31 @@ bool sendReceivePldmMessage(boost::asio::yield_context yield,
         retryCount = maxRetryCount;
     }
 
+    transport::Endpoint dst{network, eid.value_or(0)};
+    std::optional<uint32_t> generation;
     for (size_t retry = 0; retry < retryCount; retry++)
     {
-        mctpw_eid_t dstEid;
+        attempts = retry + 1;
 
-        // Input EID takes precedence over TID
-        // Usecase: TID reassignment
-        if (eid)
+        // Spread retries out instead of firing them back to back
+        if (retry > 0)
         {
-            dstEid = eid.value();
+            boost::asio::steady_timer backoff(*getIoContext(),
+                                              rtt::getBackoffDelay(retry));
+            boost::system::error_code ec;
+            backoff.async_wait(yield[ec]);
         }
-        else
+
+        // Input EID takes precedence over TID
+        // Usecase: TID reassignment
+        if (!eid && generation != getMapperGeneration())
         {
             // A PLDM device removal can cause an update to TID mapper. In such
             // case the retry should be aborted immediately.
-            if (auto eidPtr = getEidFromMapper(tid))
+            generation = getMapperGeneration();
+            if (auto endpoint = getEndpointFromMapper(tid))
             {
-                dstEid = *eidPtr;
+                dst = *endpoint;
             }
             else
             {
@@ -237,16 +456,7 @@ bool sendReceivePldmMessage(boost::asio::yield_context yield,
             }
         }
 
-        // Insert MCTP Message Type to start of the payload
-        if (retry == 0)
-        {
-            pldmReq.insert(pldmReq.begin(), PLDM);
-        }
-
-        // Clear the resp vector each time before a retry
-        pldmResp.clear();
-        if (doSendReceievePldmMessage(yield, dstEid, timeout, pldmReq,
-                                      pldmResp))
+        if (doSendReceievePldmMessage(yield, dst, timeout, pldmReq, pldmResp))
         {
             constexpr size_t minPldmMsgSize = 4;
             if (pldmResp.size() < minPldmMsgSize)
@@ -256,56 +466,40 @@ bool sendReceivePldmMessage(boost::asio::yield_context yield,
                 continue;
             }
 
-            // Verify the message received is a response
-            if (auto msgTypePtr = getPldmPacketType(pldmResp))
-            {
-                if (*msgTypePtr != PLDM_RESPONSE)
-                {
-                    phosphor::logging::log<phosphor::logging::level::WARNING>(
-                        "PLDM message received is not response");
-                    continue;
-                }
-            }
-            else
+            // Verify the response received is of type PLDM
+            constexpr int mctpMsgType = 0;
+            if (pldmResp.data()[mctpMsgType] != PLDM)
             {
                 phosphor::logging::log<phosphor::logging::level::WARNING>(
-                    "Unable to get message type");
+                    "Response received is not of message type PLDM");
                 continue;
             }
+            // Remove the MCTP message type and IC bit from resp payload.
+            // Why: Upper layer handlers(PLDM message type handlers)
+            // are not intrested in MCTP message type information and
+            // integrity check fields.
+            pldmResp.popFront();
 
-            // Verify the response received is of type PLDM
-            constexpr int mctpMsgType = 0;
-            if (pldmResp.at(mctpMsgType) == PLDM)
-            {
-                // Remove the MCTP message type and IC bit from req and resp
-                // payload.
-                // Why: Upper layer handlers(PLDM message type handlers)
-                // are not intrested in MCTP message type information and
-                // integrity check fields.
-                pldmResp.erase(pldmResp.begin());
-                pldmReq.erase(pldmReq.begin());
-            }
-            else
+            // Verify the message received is a response
+            const pldm_msg_hdr& respHdr = pldmResp.msg()->hdr;
+            if (respHdr.request != 0 || respHdr.datagram != 0)
             {
                 phosphor::logging::log<phosphor::logging::level::WARNING>(
-                    "Response received is not of message type PLDM");
+                    "PLDM message received is not response");
                 continue;
             }
 
             // Verify request and response instance ID matches
-            if (auto reqInstanceId = getInstanceId(pldmReq))
+            constexpr size_t mctpMsgTypeSize = 1;
+            auto reqHdr = reinterpret_cast<const pldm_msg_hdr*>(
+                pldmReq.data() + mctpMsgTypeSize);
+            if (reqHdr->instance_id != respHdr.instance_id)
             {
-                if (auto respInstanceId = getInstanceId(pldmResp))
-                {
-                    if (*reqInstanceId == *respInstanceId)
-                    {
-                        return true;
-                    }
-                }
+                phosphor::logging::log<phosphor::logging::level::WARNING>(
+                    "Instance ID check failed");
+                continue;
             }
-            phosphor::logging::log<phosphor::logging::level::WARNING>(
-                "Instance ID check failed");
-            continue;
+            return true;
         }
     }
     phosphor::logging::log<phosphor::logging::level::ERR>(
@@ -313,21 +507,63 @@ bool sendReceivePldmMessage(boost::asio::yield_context yield,
     return false;
 }
 
-bool sendPldmMessage(const pldm_tid_t tid, const uint8_t msgTag,
-                     const bool tagOwner, std::vector<uint8_t> payload)
+bool sendReceivePldmMessage(boost::asio::yield_context yield,
+                            const pldm_tid_t tid, const uint16_t timeout,
+                            size_t retryCount, MessageBuffer& pldmReq,
+                            MessageBuffer& pldmResp,
+                            std::optional<mctpw_eid_t> eid,
+                            const NetworkId network)
 {
-    mctpw_eid_t dstEid;
-    if (auto eidPtr = getEidFromMapper(tid))
+    if (pldmReq.size() < pldmMsgHdrSize)
     {
-        dstEid = *eidPtr;
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "PLDM message send failed. Invalid request length");
+        return false;
     }
-    else
+    const pldm_msg_hdr& reqHdr = pldmReq.msg()->hdr;
+    uint8_t instanceId = reqHdr.instance_id;
+    uint8_t pldmType = reqHdr.type;
+    uint8_t command = reqHdr.command;
+
+    // Insert MCTP Message Type in the headroom, removed before return
+    pldmReq.pushFront(PLDM);
+
+    // Retries reuse the instance ID, it stays in flight till the last one
+    const transport::Endpoint endpoint = getRequestEndpoint(tid, eid, network);
+    auto& allocator = getInstanceIdAllocator(endpoint);
+    allocator.hold(instanceId);
+    size_t attempts = 0;
+    auto start = std::chrono::steady_clock::now();
+    bool responded =
+        sendReceiveWithRetry(yield, tid, timeout, retryCount, pldmReq,
+                             pldmResp, eid, network, attempts);
+    allocator.release(instanceId, responded);
+    metrics::record(endpoint, pldmType, command, responded,
+                    attempts > 0 ? attempts - 1 : 0,
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start));
+
+    pldmReq.popFront();
+    return responded;
+}
+
+bool sendPldmMessage(const pldm_tid_t tid, const uint8_t msgTag,
+                     const bool tagOwner, std::vector<uint8_t> payload)
+{
+    auto dst = getEndpointFromMapper(tid);
+    if (!dst)
     {
         phosphor::logging::log<phosphor::logging::level::ERR>(
             "PLDM message send failed. Invalid TID");
         return false;
     }
 
+    auto service = transport::getMctpService(dst->network, dst->eid);
+    if (!service)
+    {
+        return false;
+    }
+
     // Insert MCTP Message Type to start of the payload
     payload.insert(payload.begin(), PLDM);
 
@@ -346,20 +582,22 @@ bool sendPldmMessage(const pldm_tid_t tid, const uint8_t msgTag,
                 "PLDM message send Success",
                 phosphor::logging::entry("TID=%d", tid));
         },
-        "xyz.openbmc_project.MCTP_SMBus_PCIe_slot", "/xyz/openbmc_project/mctp",
-        "xyz.openbmc_project.MCTP.Base", "SendMctpMessagePayload", dstEid,
-        msgTag, tagOwner, payload);
+        *service, "/xyz/openbmc_project/mctp", "xyz.openbmc_project.MCTP.Base",
+        "SendMctpMessagePayload", dst->eid, msgTag, tagOwner, payload);
     return true;
 }
 
 auto msgRecvCallback = [](sdbusplus::message::message& message) {
+    std::string messageTypeKey;
+    std::string vendorIdKey;
     uint8_t messageType;
     mctpw_eid_t srcEid;
     uint8_t msgTag;
     bool tagOwner;
     std::vector<uint8_t> payload;
 
-    message.read(messageType, srcEid, msgTag, tagOwner, payload);
+    message.read(messageTypeKey, vendorIdKey, messageType, srcEid, msgTag,
+                 tagOwner, payload);
 
     // Verify the response received is of type PLDM
     if (messageType == PLDM && !payload.empty() && payload.at(0) == PLDM)
@@ -367,7 +605,12 @@ auto msgRecvCallback = [](sdbusplus::message::message& message) {
 
         // Discard the packet if no matching TID is found
         // Why: We do not have to process packets from uninitialised Termini
-        if (auto tid = getTidFromMapper(srcEid))
+        auto network = transport::getNetworkId(message.get_sender());
+        if (!network)
+        {
+            return;
+        }
+        if (auto tid = getTidFromMapper(srcEid, *network))
         {
 
             payload.erase(payload.begin());
@@ -379,6 +622,10 @@ auto msgRecvCallback = [](sdbusplus::message::message& message) {
                         pldm::fwu::pldmMsgRecvCallback(*tid, msgTag, tagOwner,
                                                        payload);
                         break;
+                    case PLDM_PLATFORM:
+                        pldm::platform::pldmMsgRecvCallback(*tid, msgTag,
+                                                            tagOwner, payload);
+                        break;
                         // No use case for other PLDM message types
                     default:
                         phosphor::logging::log<phosphor::logging::level::INFO>(
@@ -400,23 +647,232 @@ void pldmMsgRecvCallbackInit()
     // TODO: Use mctp-wrapper provided api to receive PLDM message signals
     const std::string filterMsgRecvdSignal =
         sdbusplus::bus::match::rules::type::signal() +
-        sdbusplus::bus::match::rules::member("MessageReceivedSignal") +
+        sdbusplus::bus::match::rules::member("FilteredMessageReceivedSignal") +
         sdbusplus::bus::match::rules::interface(
-            "xyz.openbmc_project.MCTP.Base");
+            "xyz.openbmc_project.MCTP.Base") +
+        sdbusplus::bus::match::rules::argN(0, std::to_string(PLDM));
 
     auto bus = getSdBus();
     pldmMsgRecvMatch = std::make_unique<sdbusplus::bus::match::match>(
         *bus, filterMsgRecvdSignal, msgRecvCallback);
 }
 
-uint8_t createInstanceId(pldm_tid_t tid)
+uint8_t createInstanceId(boost::asio::yield_context yield, pldm_tid_t tid)
+{
+    return getInstanceIdAllocator(getRequestEndpoint(tid, std::nullopt, 0))
+        .allocate(yield);
+}
+
+uint8_t createInstanceId(boost::asio::yield_context yield,
+                         const mctpw_eid_t eid, const NetworkId network)
+{
+    return getInstanceIdAllocator(transport::Endpoint{network, eid})
+        .allocate(yield);
+}
+
+/** @brief Counting semaphore for coroutines
+ *
+ * Waiters park on a timer which never expires, release wakes the oldest one.
+ */
+class CoroutineLimiter
 {
-    static std::unordered_map<pldm_tid_t, uint8_t> instanceMap;
+  public:
+    CoroutineLimiter(boost::asio::io_context& ioc, const size_t limit) :
+        timer(ioc, std::chrono::steady_clock::time_point::max()), free(limit)
+    {
+    }
+
+    void acquire(boost::asio::yield_context yield)
+    {
+        while (free == 0)
+        {
+            boost::system::error_code ec;
+            timer.async_wait(yield[ec]);
+        }
+        free--;
+    }
 
-    auto& instanceId = instanceMap[tid];
+    void release()
+    {
+        free++;
+        timer.cancel_one();
+    }
 
-    instanceId = (instanceId + 1) & PLDM_INSTANCE_ID_MASK;
-    return instanceId;
+  private:
+    boost::asio::steady_timer timer;
+    size_t free;
+};
+
+using InitTask = std::function<void(boost::asio::yield_context)>;
+
+// Runs tasks in separate coroutines and returns once all of them completed
+static void runParallel(boost::asio::yield_context yield,
+                        const std::vector<InitTask>& tasks)
+{
+    auto ioc = getIoContext();
+    auto done = std::make_shared<boost::asio::steady_timer>(
+        *ioc, std::chrono::steady_clock::time_point::max());
+    auto pending = std::make_shared<size_t>(tasks.size());
+    for (const auto& task : tasks)
+    {
+        boost::asio::spawn(
+            *ioc, [task, done, pending](boost::asio::yield_context yieldTask) {
+                task(yieldTask);
+                if (--(*pending) == 0)
+                {
+                    done->cancel();
+                }
+            });
+    }
+    while (*pending)
+    {
+        boost::system::error_code ec;
+        done->async_wait(yield[ec]);
+    }
+}
+
+// Base is initialised first, it tells which of other PLDM types terminus
+// supports. Those are independent of each other and run in parallel.
+// Returns false if base init failed and the TID was released.
+static bool initTerminus(boost::asio::yield_context yield, const pldm_tid_t tid,
+                         const transport::Endpoint endpoint)
+{
+    pldm_tid_t assignedTID = 0x00;
+    SupportedPLDMTypes pldmTypes{};
+    if (!base::baseInit(yield, endpoint.eid, endpoint.network, assignedTID,
+                        pldmTypes))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "PLDM base init failed",
+            phosphor::logging::entry("EID=%d", endpoint.eid));
+        // Endpoint is not a terminus until base init succeeds
+        if (mapper.getTid(endpoint) == tid)
+        {
+            removeFromMapper(tid);
+        }
+        return false;
+    }
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "PLDM base init success",
+        phosphor::logging::entry("EID=%d", endpoint.eid));
+
+    // Endpoint may have been removed, and its TID released, meanwhile
+    auto mapped = getEndpointFromMapper(tid);
+    if (!mapped || mapped->network != endpoint.network ||
+        mapped->eid != endpoint.eid)
+    {
+        return true;
+    }
+
+    std::vector<InitTask> tasks;
+    if (base::isPldmTypeSupported(pldmTypes, PLDM_PLATFORM))
+    {
+        tasks.emplace_back([tid](boost::asio::yield_context yieldInit) {
+            if (platform::platformInit(yieldInit, tid, {}))
+            {
+                phosphor::logging::log<phosphor::logging::level::INFO>(
+                    "PLDM platform init success",
+                    phosphor::logging::entry("TID=%d", tid));
+            }
+        });
+    }
+    if (base::isPldmTypeSupported(pldmTypes, PLDM_FRU))
+    {
+        tasks.emplace_back([tid](boost::asio::yield_context yieldInit) {
+            if (fru::fruInit(yieldInit, tid))
+            {
+                phosphor::logging::log<phosphor::logging::level::INFO>(
+                    "PLDM FRU init success",
+                    phosphor::logging::entry("TID=%d", tid));
+            }
+        });
+    }
+    if (base::isPldmTypeSupported(pldmTypes, PLDM_FWU))
+    {
+        tasks.emplace_back([tid](boost::asio::yield_context yieldInit) {
+            if (fwu::fwuInit(yieldInit, tid))
+            {
+                phosphor::logging::log<phosphor::logging::level::INFO>(
+                    "PLDM FWU init success",
+                    phosphor::logging::entry("TID=%d", tid));
+            }
+        });
+    }
+    runParallel(yield, tasks);
+    return true;
+}
+
+static constexpr std::chrono::seconds baseInitRetryInterval(10);
+static constexpr unsigned baseInitRetries = 3;
+
+// Each terminus is initialised in its own coroutine, at most
+// maxParallelInit at a time. Termini on different buses don't wait for each
+// other. Failed base init is retried while the route exists, since the
+// route is reported only once.
+static void startTerminusInit(const transport::Endpoint& endpoint,
+                              const unsigned retriesLeft)
+{
+    static std::shared_ptr<CoroutineLimiter> limiter;
+
+    if (mapper.getTid(endpoint))
+    {
+        return;
+    }
+    auto tid = getFreeTid();
+    if (!tid)
+    {
+        return;
+    }
+    // TODO: Add TID to mapper only if setTID/getTID success
+    addToMapper(*tid, endpoint.eid, endpoint.network);
+
+    auto ioc = getIoContext();
+    if (!limiter)
+    {
+        limiter = std::make_shared<CoroutineLimiter>(*ioc, maxParallelInit);
+    }
+    boost::asio::spawn(*ioc, [tid = *tid, endpoint, retriesLeft](
+                                 boost::asio::yield_context yieldInit) {
+        limiter->acquire(yieldInit);
+        bool baseReady = initTerminus(yieldInit, tid, endpoint);
+        limiter->release();
+        if (baseReady || retriesLeft == 0)
+        {
+            return;
+        }
+
+        boost::system::error_code ec;
+        boost::asio::steady_timer retryTimer(*getIoContext(),
+                                             baseInitRetryInterval);
+        retryTimer.async_wait(yieldInit[ec]);
+        if (transport::getMctpService(endpoint.network, endpoint.eid))
+        {
+            startTerminusInit(endpoint, retriesLeft - 1);
+        }
+    });
+}
+
+void addTerminus(const transport::Endpoint& endpoint)
+{
+    startTerminusInit(endpoint, baseInitRetries);
+}
+
+static constexpr std::chrono::seconds transportInitRetryInterval(5);
+
+// Termini are initialised as transport discovers their routes, both during
+// transportInit and later on hot-plug or MCTP service restart. Retried until
+// MCTP services can be looked up.
+static void initTermini(boost::asio::yield_context yield)
+{
+    boost::asio::steady_timer retryTimer(*getIoContext());
+    while (!transport::transportInit(yield))
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "MCTP transport init failed, retrying");
+        boost::system::error_code ec;
+        retryTimer.expires_after(transportInitRetryInterval);
+        retryTimer.async_wait(yield[ec]);
+    }
 }
 } // namespace pldm
 
@@ -429,6 +885,8 @@ extern void setObjServer(
 
 int main(void)
 {
+    pldm::initializeLogging();
+
     auto ioc = std::make_shared<boost::asio::io_context>();
     setIoContext(ioc);
     boost::asio::signal_set signals(*ioc, SIGINT, SIGTERM);
@@ -448,37 +906,11 @@ int main(void)
     // Register for PLDM message signals
     pldm::pldmMsgRecvCallbackInit();
 
-    // TODO: List Endpoints that support registered PLDM message type
+    pldm::rtt::registerDiagnostics();
+    pldm::metrics::registerInterface();
+    pldm::platform::registerSensorReadings();
 
-    // Using dummy EID exposed by emulator until the discovery is implemented
-    mctpw_eid_t dummyEid = 20;
-    auto tid = pldm::getFreeTid();
-    if (tid)
-    {
-        // TODO: Add TID to mapper only if setTID/getTID success
-        pldm::addToMapper(*tid, dummyEid);
-
-        // TODO: Assign TID and find supported PLDM type and execute
-        // corresponding init methods
-
-        // Create yield context for each new TID and pass to the Init methods
-        boost::asio::spawn(
-            *ioc, [&tid, &dummyEid](boost::asio::yield_context yield) {
-                pldm_tid_t assignedTID = 0x00;
-                if (pldm::base::baseInit(yield, dummyEid, assignedTID))
-                {
-                    phosphor::logging::log<phosphor::logging::level::INFO>(
-                        "PLDM base init success",
-                        phosphor::logging::entry("EID=%d", dummyEid));
-                }
-                if (pldm::platform::platformInit(yield, *tid, {}))
-                {
-                    phosphor::logging::log<phosphor::logging::level::INFO>(
-                        "PLDM platform init success",
-                        phosphor::logging::entry("TID=%d", *tid));
-                }
-            });
-    }
+    boost::asio::spawn(*ioc, pldm::initTermini);
     ioc->run();
 
     return 0;
@@ -0,0 +1,101 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pldm.hpp"
+
+#include "rtt_estimator.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <tuple>
+
+namespace pldm
+{
+namespace rtt
+{
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+static constexpr const char* diagnosticsPath = "/xyz/openbmc_project/pldm";
+static constexpr const char* diagnosticsInterface =
+    "xyz.openbmc_project.PLDM.Diagnostics";
+
+static constexpr milliseconds backoffBase(10);
+static constexpr milliseconds maxBackoff(500);
+
+static std::map<std::pair<NetworkId, mctpw_eid_t>, RttEstimator> estimators;
+
+static RttEstimator& getEstimator(const transport::Endpoint& dst)
+{
+    return estimators[std::make_pair(dst.network, dst.eid)];
+}
+
+milliseconds getTimeout(const transport::Endpoint& dst,
+                        const milliseconds initial)
+{
+    return getEstimator(dst).getTimeout(initial);
+}
+
+void addSample(const transport::Endpoint& dst, const microseconds rtt)
+{
+    getEstimator(dst).addSample(rtt);
+}
+
+void onTimeout(const transport::Endpoint& dst)
+{
+    getEstimator(dst).onTimeout();
+}
+
+milliseconds getBackoffDelay(const size_t retry)
+{
+    static std::mt19937 generator{std::random_device{}()};
+
+    // Full jitter, retries of termini failing together do not line up
+    constexpr size_t maxShift = 16;
+    milliseconds limit = std::min(
+        backoffBase * (1 << std::min(retry - 1, maxShift)), maxBackoff);
+    std::uniform_int_distribution<milliseconds::rep> distribution(
+        0, limit.count());
+    return milliseconds(distribution(generator));
+}
+
+void registerDiagnostics()
+{
+    auto objServer = getObjServer();
+    auto iface =
+        objServer->add_interface(diagnosticsPath, diagnosticsInterface);
+    // Network, EID, SRTT(us), RTTVAR(us), timeout(ms), samples, timeouts
+    iface->register_method("GetRttEstimates", []() {
+        std::vector<std::tuple<uint8_t, uint8_t, uint32_t, uint32_t, uint32_t,
+                               uint32_t, uint32_t>>
+            result;
+        for (const auto& [address, estimator] : estimators)
+        {
+            result.emplace_back(
+                address.first, address.second,
+                static_cast<uint32_t>(estimator.getSrtt().count()),
+                static_cast<uint32_t>(estimator.getRttvar().count()),
+                static_cast<uint32_t>(estimator.getRto().count()),
+                estimator.getSamples(), estimator.getTimeouts());
+        }
+        return result;
+    });
+    iface->initialize();
+}
+
+} // namespace rtt
+} // namespace pldm
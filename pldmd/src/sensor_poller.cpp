@@ -0,0 +1,547 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sensor_poller.hpp"
+
+#include "platform.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <phosphor-logging/log.hpp>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <unordered_map>
+
+namespace pldm
+{
+namespace platform
+{
+
+// Outstanding sensor requests, termini often serve one request at a time and
+// SMBus carries one transfer at a time
+static constexpr size_t maxTerminusRequests = 1;
+static constexpr size_t maxNetworkRequests = 4;
+// Missed reading is refreshed by next poll, retries would only delay others
+static constexpr size_t pollRetryCount = 1;
+// Disabled and unavailable sensors are checked at this rate
+static constexpr std::chrono::seconds inactiveInterval(30);
+// State sensor is trusted to report its changes after this many events, then
+// it is polled only to catch lost events. Numeric sensors report readings only
+// on threshold crossings and keep being polled.
+static constexpr uint32_t trustedEventCount = 3;
+static constexpr std::chrono::seconds eventDrivenInterval(60);
+
+static constexpr const char* readingsPath = "/xyz/openbmc_project/pldm";
+static constexpr const char* readingsInterface =
+    "xyz.openbmc_project.PLDM.SensorReadings";
+
+using Clock = std::chrono::steady_clock;
+
+struct Reading
+{
+    uint8_t operationalState;
+    double value = 0;
+    std::array<uint8_t, 8> presentStates{};
+};
+
+struct PolledTerminus
+{
+    std::vector<Sensor> sensors;
+    std::unordered_map<uint16_t, size_t> sensorIndexes;
+    // Indexes of sensors due but waiting for request slot
+    std::deque<size_t> ready;
+    size_t inFlight = 0;
+    uint32_t overruns = 0;
+    // Distinguishes sensors of terminus restarted meanwhile
+    uint32_t generation;
+};
+
+struct ScheduledPoll
+{
+    Clock::time_point due;
+    pldm_tid_t tid;
+    uint32_t generation;
+    size_t index;
+
+    bool operator>(const ScheduledPoll& other) const
+    {
+        return due > other.due;
+    }
+};
+
+static std::map<pldm_tid_t, PolledTerminus> termini;
+static std::priority_queue<ScheduledPoll, std::vector<ScheduledPoll>,
+                           std::greater<ScheduledPoll>>
+    schedule;
+static std::map<NetworkId, size_t> networkInFlight;
+static uint32_t nextGeneration = 0;
+// Round robin start among termini waiting for network request slot
+static pldm_tid_t lastServed = 0;
+static std::unique_ptr<boost::asio::steady_timer> wakeup;
+
+// Raw reading is sign extended according to its data size
+static double toValue(const Sensor& sensor, const uint8_t dataSize,
+                      const uint32_t raw)
+{
+    double value;
+    switch (dataSize)
+    {
+        case PLDM_SENSOR_DATA_SIZE_SINT8:
+            value = static_cast<int8_t>(raw);
+            break;
+        case PLDM_SENSOR_DATA_SIZE_SINT16:
+            value = static_cast<int16_t>(raw);
+            break;
+        case PLDM_SENSOR_DATA_SIZE_SINT32:
+            value = static_cast<int32_t>(raw);
+            break;
+        default:
+            value = raw;
+            break;
+    }
+    return (value * static_cast<double>(sensor.resolution) +
+            static_cast<double>(sensor.offset)) *
+           std::pow(10.0, sensor.unitModifier);
+}
+
+static bool isEventDriven(const Sensor& sensor)
+{
+    return sensor.type == Sensor::Type::state &&
+           sensor.eventCount >= trustedEventCount;
+}
+
+static std::optional<Reading>
+    readNumericSensor(boost::asio::yield_context yield, const pldm_tid_t tid,
+                      const Sensor& sensor)
+{
+    MessageBuffer request(pldmMsgHdrSize + PLDM_GET_SENSOR_READING_REQ_BYTES);
+    int rc = encode_get_sensor_reading_req(createInstanceId(yield, tid),
+                                           sensor.id, false, request.msg());
+    if (!validatePLDMReqEncode(tid, rc, "GetSensorReading"))
+    {
+        return std::nullopt;
+    }
+
+    MessageBuffer response;
+    if (!sendReceivePldmMessage(yield, tid, commandTimeout, pollRetryCount,
+                                request, response))
+    {
+        return std::nullopt;
+    }
+
+    uint8_t completionCode;
+    uint8_t dataSize = PLDM_SENSOR_DATA_SIZE_SINT32;
+    uint8_t operationalState;
+    uint8_t eventMessageEnable;
+    uint8_t presentState;
+    uint8_t previousState;
+    uint8_t eventState;
+    std::array<uint8_t, sizeof(uint32_t)> presentReading{};
+    rc = decode_get_sensor_reading_resp(
+        response.msg(), response.size() - pldmMsgHdrSize, &completionCode,
+        &dataSize, &operationalState, &eventMessageEnable, &presentState,
+        &previousState, &eventState, presentReading.data());
+    if (!validatePLDMRespDecode(tid, rc, completionCode, "GetSensorReading"))
+    {
+        return std::nullopt;
+    }
+
+    // Decoder stores reading in host order with its own width
+    uint32_t raw = 0;
+    switch (dataSize)
+    {
+        case PLDM_SENSOR_DATA_SIZE_UINT8:
+        case PLDM_SENSOR_DATA_SIZE_SINT8:
+            raw = presentReading[0];
+            break;
+        case PLDM_SENSOR_DATA_SIZE_UINT16:
+        case PLDM_SENSOR_DATA_SIZE_SINT16:
+        {
+            uint16_t value;
+            std::memcpy(&value, presentReading.data(), sizeof(value));
+            raw = value;
+            break;
+        }
+        default:
+            std::memcpy(&raw, presentReading.data(), sizeof(raw));
+            break;
+    }
+    Reading reading{operationalState};
+    reading.value = toValue(sensor, dataSize, raw);
+    return reading;
+}
+
+static std::optional<Reading> readStateSensor(boost::asio::yield_context yield,
+                                              const pldm_tid_t tid,
+                                              const Sensor& sensor)
+{
+    MessageBuffer request(pldmMsgHdrSize +
+                          PLDM_GET_STATE_SENSOR_READINGS_REQ_BYTES);
+    bitfield8_t rearm{};
+    int rc = encode_get_state_sensor_readings_req(
+        createInstanceId(yield, tid), sensor.id, rearm, 0, request.msg());
+    if (!validatePLDMReqEncode(tid, rc, "GetStateSensorReadings"))
+    {
+        return std::nullopt;
+    }
+
+    MessageBuffer response;
+    if (!sendReceivePldmMessage(yield, tid, commandTimeout, pollRetryCount,
+                                request, response))
+    {
+        return std::nullopt;
+    }
+
+    uint8_t completionCode;
+    std::array<get_sensor_state_field, 8> fields{};
+    uint8_t count = static_cast<uint8_t>(fields.size());
+    rc = decode_get_state_sensor_readings_resp(
+        response.msg(), response.size() - pldmMsgHdrSize, &completionCode,
+        &count, fields.data());
+    if (!validatePLDMRespDecode(tid, rc, completionCode,
+                                "GetStateSensorReadings"))
+    {
+        return std::nullopt;
+    }
+    if (count == 0)
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "GetStateSensorReadings: No sensor in response",
+            phosphor::logging::entry("TID=%d", tid));
+        return std::nullopt;
+    }
+
+    // Composite sensor is active while any of its sensors is
+    Reading reading{fields[0].sensor_op_state};
+    for (uint8_t i = 0; i < count; i++)
+    {
+        reading.presentStates[i] = fields[i].present_state;
+        if (fields[i].sensor_op_state == PLDM_SENSOR_ENABLED)
+        {
+            reading.operationalState = PLDM_SENSOR_ENABLED;
+        }
+    }
+    return reading;
+}
+
+static bool isInactive(const uint8_t operationalState)
+{
+    return operationalState == PLDM_SENSOR_DISABLED ||
+           operationalState == PLDM_SENSOR_UNAVAILABLE;
+}
+
+static void onPollDone(const pldm_tid_t tid, const uint32_t generation,
+                       const size_t index, const NetworkId network,
+                       const std::optional<Reading>& reading)
+{
+    networkInFlight[network]--;
+    wakeup->cancel();
+
+    auto terminus = termini.find(tid);
+    if (terminus == termini.end() ||
+        terminus->second.generation != generation)
+    {
+        return;
+    }
+    terminus->second.inFlight--;
+
+    auto& sensor = terminus->second.sensors[index];
+    if (reading)
+    {
+        if (isEventDriven(sensor) &&
+            reading->presentStates != sensor.presentStates)
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Sensor state changed without event, polling resumed",
+                phosphor::logging::entry("TID=%d", tid),
+                phosphor::logging::entry("SENSOR_ID=%d", sensor.id));
+            sensor.eventCount = 0;
+        }
+        sensor.operationalState = reading->operationalState;
+        sensor.value = reading->value;
+        sensor.presentStates = reading->presentStates;
+        sensor.updated = Clock::now();
+    }
+
+    // Keep the phase so that polls stay spread, unless running late
+    auto now = Clock::now();
+    if (reading && isInactive(reading->operationalState))
+    {
+        sensor.nextPoll = now + inactiveInterval;
+    }
+    else if (isEventDriven(sensor))
+    {
+        sensor.nextPoll = now + eventDrivenInterval;
+    }
+    else
+    {
+        sensor.nextPoll = std::max(sensor.nextPoll + sensor.interval, now);
+    }
+    schedule.push(ScheduledPoll{sensor.nextPoll, tid, generation, index});
+}
+
+static void startPoll(const pldm_tid_t tid, PolledTerminus& terminus,
+                      const NetworkId network, const size_t index)
+{
+    terminus.inFlight++;
+    networkInFlight[network]++;
+
+    // Request slots of the terminus can't keep up with sensor intervals
+    auto& scheduled = terminus.sensors[index];
+    if (Clock::now() - scheduled.nextPoll >= scheduled.interval)
+    {
+        scheduled.overruns++;
+        if (terminus.overruns++ == 0)
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Sensor poll overrun, polls are delayed past their interval",
+                phosphor::logging::entry("TID=%d", tid),
+                phosphor::logging::entry("SENSOR_ID=%d", scheduled.id));
+        }
+    }
+
+    const Sensor sensor = scheduled;
+    boost::asio::spawn(
+        *getIoContext(),
+        [tid, generation = terminus.generation, index, network,
+         sensor](boost::asio::yield_context yield) {
+            auto reading = sensor.type == Sensor::Type::numeric
+                               ? readNumericSensor(yield, tid, sensor)
+                               : readStateSensor(yield, tid, sensor);
+            onPollDone(tid, generation, index, network, reading);
+        });
+}
+
+static void startReadyPolls(const pldm_tid_t tid, PolledTerminus& terminus)
+{
+    if (terminus.ready.empty())
+    {
+        return;
+    }
+    auto endpoint = getEndpointFromMapper(tid);
+    if (!endpoint)
+    {
+        // Terminus lost its endpoint, retry at low rate until it is mapped
+        // again or polling is stopped
+        auto retry = Clock::now() + inactiveInterval;
+        for (size_t index : terminus.ready)
+        {
+            terminus.sensors[index].nextPoll = retry;
+            schedule.push(
+                ScheduledPoll{retry, tid, terminus.generation, index});
+        }
+        terminus.ready.clear();
+        return;
+    }
+    auto& networkRequests = networkInFlight[endpoint->network];
+    while (!terminus.ready.empty() &&
+           terminus.inFlight < maxTerminusRequests &&
+           networkRequests < maxNetworkRequests)
+    {
+        size_t index = terminus.ready.front();
+        terminus.ready.pop_front();
+        startPoll(tid, terminus, endpoint->network, index);
+        lastServed = tid;
+    }
+}
+
+static void runScheduler(boost::asio::yield_context yield)
+{
+    while (true)
+    {
+        auto now = Clock::now();
+        while (!schedule.empty() && schedule.top().due <= now)
+        {
+            auto poll = schedule.top();
+            schedule.pop();
+            auto terminus = termini.find(poll.tid);
+            if (terminus != termini.end() &&
+                terminus->second.generation == poll.generation)
+            {
+                terminus->second.ready.push_back(poll.index);
+            }
+        }
+
+        // Start after last served terminus so that none starves when network
+        // request slots are scarce
+        auto first = termini.upper_bound(lastServed);
+        for (auto it = first; it != termini.end(); it++)
+        {
+            startReadyPolls(it->first, it->second);
+        }
+        for (auto it = termini.begin(); it != first; it++)
+        {
+            startReadyPolls(it->first, it->second);
+        }
+
+        // Woken up early by completed polls and started termini
+        wakeup->expires_at(schedule.empty() ? Clock::time_point::max()
+                                            : schedule.top().due);
+        boost::system::error_code ec;
+        wakeup->async_wait(yield[ec]);
+    }
+}
+
+void startSensorPolling(const pldm_tid_t tid, std::vector<Sensor> sensors)
+{
+    static std::mt19937 generator{std::random_device{}()};
+
+    if (!wakeup)
+    {
+        wakeup = std::make_unique<boost::asio::steady_timer>(*getIoContext());
+        boost::asio::spawn(*getIoContext(), runScheduler);
+    }
+
+    auto& terminus = termini[tid];
+    terminus = PolledTerminus{};
+    terminus.generation = nextGeneration++;
+    terminus.sensors = std::move(sensors);
+    for (size_t index = 0; index < terminus.sensors.size(); index++)
+    {
+        terminus.sensorIndexes.emplace(terminus.sensors[index].id, index);
+    }
+
+    auto now = Clock::now();
+    for (size_t index = 0; index < terminus.sensors.size(); index++)
+    {
+        auto& sensor = terminus.sensors[index];
+        std::uniform_int_distribution<std::chrono::milliseconds::rep> phase(
+            0, sensor.interval.count());
+        sensor.nextPoll = now + std::chrono::milliseconds(phase(generator));
+        schedule.push(
+            ScheduledPoll{sensor.nextPoll, tid, terminus.generation, index});
+    }
+    wakeup->cancel();
+
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "Sensor polling started", phosphor::logging::entry("TID=%d", tid),
+        phosphor::logging::entry("SENSOR_COUNT=%d",
+                                 static_cast<int>(terminus.sensors.size())));
+}
+
+bool onSensorEvent(const pldm_tid_t tid, const SensorEvent& event)
+{
+    auto terminus = termini.find(tid);
+    if (terminus == termini.end())
+    {
+        return false;
+    }
+    auto index = terminus->second.sensorIndexes.find(event.sensorId);
+    if (index == terminus->second.sensorIndexes.end())
+    {
+        return false;
+    }
+
+    auto& sensor = terminus->second.sensors[index->second];
+    switch (event.eventClass)
+    {
+        case PLDM_SENSOR_OP_STATE:
+            sensor.operationalState = event.operationalState;
+            break;
+        case PLDM_STATE_SENSOR_STATE:
+            if (sensor.type != Sensor::Type::state ||
+                event.sensorOffset >= sensor.presentStates.size())
+            {
+                return false;
+            }
+            sensor.presentStates[event.sensorOffset] = event.state;
+            sensor.eventCount++;
+            break;
+        case PLDM_NUMERIC_SENSOR_STATE:
+            if (sensor.type != Sensor::Type::numeric)
+            {
+                return false;
+            }
+            sensor.value =
+                toValue(sensor, event.dataSize, event.presentReading);
+            sensor.eventCount++;
+            break;
+        default:
+            return false;
+    }
+    sensor.updated = Clock::now();
+    return true;
+}
+
+void stopSensorPolling(const pldm_tid_t tid)
+{
+    // Scheduled polls and polls in flight are dropped by generation check
+    termini.erase(tid);
+}
+
+std::optional<Sensor> getSensor(const pldm_tid_t tid, const uint16_t sensorId)
+{
+    auto terminus = termini.find(tid);
+    if (terminus == termini.end())
+    {
+        return std::nullopt;
+    }
+    auto index = terminus->second.sensorIndexes.find(sensorId);
+    if (index == terminus->second.sensorIndexes.end())
+    {
+        return std::nullopt;
+    }
+    return terminus->second.sensors[index->second];
+}
+
+void registerSensorReadings()
+{
+    auto objServer = getObjServer();
+    auto iface = objServer->add_interface(readingsPath, readingsInterface);
+    // Sensor ID, operational state, value in base unit, present states of
+    // composite sensors, age of the reading(ms, UINT32_MAX if none yet),
+    // overruns
+    iface->register_method("GetSensorReadings", [](const uint8_t tid) {
+        std::vector<std::tuple<uint16_t, uint8_t, double, std::vector<uint8_t>,
+                               uint32_t, uint32_t>>
+            result;
+        auto terminus = termini.find(tid);
+        if (terminus == termini.end())
+        {
+            return result;
+        }
+        auto now = Clock::now();
+        for (const auto& sensor : terminus->second.sensors)
+        {
+            uint32_t age = std::numeric_limits<uint32_t>::max();
+            if (sensor.updated != Clock::time_point{})
+            {
+                age = static_cast<uint32_t>(std::min<int64_t>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        now - sensor.updated)
+                        .count(),
+                    age));
+            }
+            size_t states = std::min<size_t>(sensor.compositeCount,
+                                             sensor.presentStates.size());
+            result.emplace_back(
+                sensor.id, sensor.operationalState, sensor.value,
+                std::vector<uint8_t>(sensor.presentStates.begin(),
+                                     sensor.presentStates.begin() +
+                                         static_cast<ptrdiff_t>(states)),
+                age, sensor.overruns);
+        }
+        return result;
+    });
+    iface->initialize();
+}
+
+} // namespace platform
+} // namespace pldm
@@ -0,0 +1,405 @@
+/**
+ * Copyright © 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pldm.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <map>
+#include <phosphor-logging/log.hpp>
+#include <set>
+#include <unordered_map>
+
+namespace pldm
+{
+namespace transport
+{
+
+static constexpr const char* mctpPath = "/xyz/openbmc_project/mctp";
+static constexpr const char* mctpDevicePath =
+    "/xyz/openbmc_project/mctp/device/";
+static constexpr const char* mctpBaseInterface =
+    "xyz.openbmc_project.MCTP.Base";
+static constexpr const char* endpointInterface =
+    "xyz.openbmc_project.MCTP.Endpoint";
+static constexpr const char* msgTypesInterface =
+    "xyz.openbmc_project.MCTP.SupportedMessageTypes";
+
+using PropertyValue =
+    std::variant<uint16_t, int16_t, int32_t, uint32_t, bool, std::string,
+                 uint8_t, std::vector<uint8_t>>;
+using Properties = std::map<std::string, PropertyValue>;
+using Interfaces = std::map<std::string, Properties>;
+using ManagedObjects = std::map<sdbusplus::message::object_path, Interfaces>;
+
+// Endpoint as exposed by one of mctpd instances(one per binding and bus)
+struct Route
+{
+    bool pldmSupported = false;
+};
+
+// Each MCTP service is treated as separate network with its own EID space.
+// Services are identified by unique connection name since that is the
+// sender of their signals, index in the table is the NetworkId. Empty entry
+// is a free NetworkId.
+static std::vector<std::string> networks;
+static std::map<std::pair<NetworkId, mctpw_eid_t>, Route> routes;
+static std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+// Unknown signal senders being checked for MCTP.Base
+static std::set<std::string> pendingServices;
+// Reassembly limit of each network's binding
+static std::map<NetworkId, size_t> maxMessageSizes;
+
+static std::optional<mctpw_eid_t> getEidFromPath(const std::string& path)
+{
+    const std::string prefix(mctpDevicePath);
+    if (path.compare(0, prefix.size(), prefix) != 0)
+    {
+        return std::nullopt;
+    }
+    const char* begin = path.data() + prefix.size();
+    const char* end = path.data() + path.size();
+    mctpw_eid_t eid = 0;
+    auto result = std::from_chars(begin, end, eid);
+    if (result.ec != std::errc() || result.ptr != end)
+    {
+        return std::nullopt;
+    }
+    return eid;
+}
+
+static std::optional<NetworkId> addNetwork(const std::string& uniqueName)
+{
+    if (auto network = getNetworkId(uniqueName))
+    {
+        return network;
+    }
+    // Termini of removed network are already released, its ID can be reused
+    auto freeNetwork = std::find(networks.begin(), networks.end(), "");
+    if (freeNetwork != networks.end())
+    {
+        *freeNetwork = uniqueName;
+        return static_cast<NetworkId>(freeNetwork - networks.begin());
+    }
+    constexpr size_t maxNetworks = std::numeric_limits<NetworkId>::max() + 1;
+    if (networks.size() >= maxNetworks)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "No free MCTP network ID",
+            phosphor::logging::entry("SERVICE=%s", uniqueName.c_str()));
+        return std::nullopt;
+    }
+    networks.push_back(uniqueName);
+    return static_cast<NetworkId>(networks.size() - 1);
+}
+
+static void addRoute(const NetworkId network, const mctpw_eid_t eid,
+                     const Interfaces& interfaces)
+{
+    auto& route = routes[std::make_pair(network, eid)];
+
+    auto msgTypes = interfaces.find(msgTypesInterface);
+    if (msgTypes != interfaces.end())
+    {
+        auto pldm = msgTypes->second.find("PLDM");
+        if (pldm != msgTypes->second.end())
+        {
+            if (auto value = std::get_if<bool>(&pldm->second))
+            {
+                if (*value && !route.pldmSupported)
+                {
+                    addTerminus(Endpoint{network, eid});
+                }
+                route.pldmSupported = *value;
+            }
+        }
+    }
+}
+
+static void removeNetwork(const NetworkId network)
+{
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "MCTP network removed",
+        phosphor::logging::entry("NETWORK=%d", network),
+        phosphor::logging::entry("SERVICE=%s", networks[network].c_str()));
+    networks[network].clear();
+    maxMessageSizes.erase(network);
+    auto first = routes.lower_bound(std::make_pair(network, mctpw_eid_t{0}));
+    auto last = routes.upper_bound(
+        std::make_pair(network, std::numeric_limits<mctpw_eid_t>::max()));
+    for (auto route = first; route != last; route++)
+    {
+        removeTerminus(Endpoint{network, route->first.second});
+    }
+    routes.erase(first, last);
+}
+
+// Reads endpoints of MCTP service and tracks it as separate network
+static void addService(boost::asio::yield_context yield,
+                       const std::string& uniqueName)
+{
+    boost::system::error_code ec;
+    auto objects = getSdBus()->yield_method_call<ManagedObjects>(
+        yield, ec, uniqueName.c_str(), mctpPath,
+        "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    if (ec)
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "Failed to read MCTP endpoints",
+            phosphor::logging::entry("SERVICE=%s", uniqueName.c_str()),
+            phosphor::logging::entry("ERROR=%s", ec.message().c_str()));
+        return;
+    }
+
+    // mctpd not reporting the limit reassembles as much as libmctp allows
+    size_t maxMessageSize = defaultMaxMessageSize;
+    auto size = getSdBus()->yield_method_call<std::variant<uint32_t>>(
+        yield, ec, uniqueName.c_str(), mctpPath,
+        "org.freedesktop.DBus.Properties", "Get", mctpBaseInterface,
+        "MaxMessageSize");
+    if (!ec)
+    {
+        maxMessageSize = std::get<uint32_t>(size);
+    }
+
+    auto network = addNetwork(uniqueName);
+    if (!network)
+    {
+        return;
+    }
+    maxMessageSizes[*network] = maxMessageSize;
+
+    for (const auto& [path, objectInterfaces] : objects)
+    {
+        auto eid = getEidFromPath(path);
+        if (eid &&
+            objectInterfaces.find(endpointInterface) != objectInterfaces.end())
+        {
+            addRoute(*network, *eid, objectInterfaces);
+        }
+    }
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "MCTP service discovered",
+        phosphor::logging::entry("SERVICE=%s", uniqueName.c_str()),
+        phosphor::logging::entry("NETWORK=%d", *network));
+}
+
+// Service started after transportInit is learned from its signals. Sender is
+// tracked as network only if it implements MCTP.Base, its endpoints are read
+// afterwards so signals dropped meanwhile are not missed.
+static void discoverService(const std::string& uniqueName)
+{
+    if (uniqueName.empty() || !pendingServices.insert(uniqueName).second)
+    {
+        return;
+    }
+    boost::asio::spawn(*getIoContext(), [uniqueName](
+                                            boost::asio::yield_context yield) {
+        boost::system::error_code ec;
+        getSdBus()->yield_method_call<std::variant<uint8_t>>(
+            yield, ec, uniqueName.c_str(), mctpPath,
+            "org.freedesktop.DBus.Properties", "Get", mctpBaseInterface, "Eid");
+        // Entry is dropped if owner left while waiting for reply
+        if (!ec && pendingServices.count(uniqueName))
+        {
+            addService(yield, uniqueName);
+        }
+        pendingServices.erase(uniqueName);
+    });
+}
+
+static void onInterfacesAdded(sdbusplus::message::message& message)
+{
+    sdbusplus::message::object_path path;
+    Interfaces interfaces;
+    try
+    {
+        message.read(path, interfaces);
+    }
+    catch (const std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to read InterfacesAdded signal",
+            phosphor::logging::entry("ERROR=%s", e.what()));
+        return;
+    }
+
+    // Endpoint and its message types are announced by separate signals
+    auto eid = getEidFromPath(path);
+    if (!eid || (interfaces.find(endpointInterface) == interfaces.end() &&
+                 interfaces.find(msgTypesInterface) == interfaces.end()))
+    {
+        return;
+    }
+    auto network = getNetworkId(message.get_sender());
+    if (!network)
+    {
+        discoverService(message.get_sender());
+        return;
+    }
+    addRoute(*network, *eid, interfaces);
+    phosphor::logging::log<phosphor::logging::level::INFO>(
+        "MCTP route added", phosphor::logging::entry("EID=%d", *eid),
+        phosphor::logging::entry("NETWORK=%d", *network));
+}
+
+static void onInterfacesRemoved(sdbusplus::message::message& message)
+{
+    sdbusplus::message::object_path path;
+    std::vector<std::string> interfaces;
+    try
+    {
+        message.read(path, interfaces);
+    }
+    catch (const std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to read InterfacesRemoved signal",
+            phosphor::logging::entry("ERROR=%s", e.what()));
+        return;
+    }
+
+    auto eid = getEidFromPath(path);
+    auto network = getNetworkId(message.get_sender());
+    if (!eid || !network ||
+        std::find(interfaces.begin(), interfaces.end(), endpointInterface) ==
+            interfaces.end())
+    {
+        return;
+    }
+    if (routes.erase(std::make_pair(*network, *eid)))
+    {
+        removeTerminus(Endpoint{*network, *eid});
+    }
+}
+
+static void onNameOwnerChanged(sdbusplus::message::message& message)
+{
+    std::string name;
+    std::string oldOwner;
+    std::string newOwner;
+    try
+    {
+        message.read(name, oldOwner, newOwner);
+    }
+    catch (const std::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to read NameOwnerChanged signal",
+            phosphor::logging::entry("ERROR=%s", e.what()));
+        return;
+    }
+    if (!newOwner.empty())
+    {
+        return;
+    }
+    pendingServices.erase(name);
+    if (auto network = getNetworkId(name))
+    {
+        removeNetwork(*network);
+    }
+}
+
+static void registerSignals()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+    auto bus = getSdBus();
+
+    matches.clear();
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesAdded() + rules::argNpath(0, mctpDevicePath),
+        onInterfacesAdded));
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesRemoved() + rules::argNpath(0, mctpDevicePath),
+        onInterfacesRemoved));
+    // Only names losing their owner, networks are known by unique names
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::nameOwnerChanged() + rules::argN(2, ""),
+        onNameOwnerChanged));
+}
+
+bool transportInit(boost::asio::yield_context yield)
+{
+    // Subscribe before reading the object trees so no endpoint is missed
+    registerSignals();
+
+    boost::system::error_code ec;
+    auto bus = getSdBus();
+    auto services = bus->yield_method_call<
+        std::map<std::string, std::vector<std::string>>>(
+        yield, ec, "xyz.openbmc_project.ObjectMapper",
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetObject", mctpPath,
+        std::vector<std::string>{mctpBaseInterface});
+    if (ec)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to find MCTP services",
+            phosphor::logging::entry("ERROR=%s", ec.message().c_str()));
+        return false;
+    }
+
+    for (const auto& [service, interfaces] : services)
+    {
+        // Signals carry unique name, resolve it to identify the network
+        auto uniqueName = bus->yield_method_call<std::string>(
+            yield, ec, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+            "org.freedesktop.DBus", "GetNameOwner", service);
+        if (ec)
+        {
+            phosphor::logging::log<phosphor::logging::level::WARNING>(
+                "Failed to get MCTP service owner",
+                phosphor::logging::entry("SERVICE=%s", service.c_str()),
+                phosphor::logging::entry("ERROR=%s", ec.message().c_str()));
+            continue;
+        }
+        addService(yield, uniqueName);
+    }
+    return true;
+}
+
+std::optional<NetworkId> getNetworkId(const std::string& uniqueName)
+{
+    auto it = std::find(networks.begin(), networks.end(), uniqueName);
+    if (uniqueName.empty() || it == networks.end())
+    {
+        return std::nullopt;
+    }
+    return static_cast<NetworkId>(it - networks.begin());
+}
+
+std::optional<std::string> getMctpService(const NetworkId network,
+                                          const mctpw_eid_t eid)
+{
+    if (routes.find(std::make_pair(network, eid)) == routes.end())
+    {
+        phosphor::logging::log<phosphor::logging::level::WARNING>(
+            "No MCTP route found for EID",
+            phosphor::logging::entry("EID=%d", eid),
+            phosphor::logging::entry("NETWORK=%d", network));
+        return std::nullopt;
+    }
+    return networks[network];
+}
+
+size_t getMaxMessageSize(const NetworkId network)
+{
+    auto it = maxMessageSizes.find(network);
+    return it != maxMessageSizes.end() ? it->second : defaultMaxMessageSize;
+}
+
+} // namespace transport
+} // namespace pldm
@@ -0,0 +1,45 @@
+#include "command_metrics.hpp"
+
+#include <gtest/gtest.h>
+
+using pldm::metrics::CommandMetrics;
+using pldm::metrics::latencyBuckets;
+using std::chrono::microseconds;
+
+TEST(CommandMetrics, Counters)
+{
+    CommandMetrics metrics;
+    metrics.record(true, 0, microseconds(100));
+    metrics.record(false, 2, microseconds(300));
+    EXPECT_EQ(metrics.count, 2u);
+    EXPECT_EQ(metrics.failures, 1u);
+    EXPECT_EQ(metrics.retries, 2u);
+    EXPECT_EQ(metrics.totalLatency, 400u);
+}
+
+TEST(CommandMetrics, HistogramBuckets)
+{
+    CommandMetrics metrics;
+    ASSERT_EQ(metrics.histogram.size(), latencyBuckets.size() + 1);
+
+    // Bucket upper bounds are inclusive
+    metrics.record(true, 0, microseconds(latencyBuckets[0]));
+    metrics.record(true, 0, microseconds(latencyBuckets[0] + 1));
+    metrics.record(true, 0, microseconds(latencyBuckets.back() + 1));
+
+    EXPECT_EQ(metrics.histogram[0], 1u);
+    EXPECT_EQ(metrics.histogram[1], 1u);
+    EXPECT_EQ(metrics.histogram.back(), 1u);
+    uint32_t total = 0;
+    for (auto bucket : metrics.histogram)
+    {
+        total += bucket;
+    }
+    EXPECT_EQ(total, metrics.count);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
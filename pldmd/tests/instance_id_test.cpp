@@ -0,0 +1,91 @@
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/spawn.hpp>
+#include <set>
+#include <vector>
+
+#include "instance_id.hpp"
+
+#include <gtest/gtest.h>
+
+using pldm::InstanceIdAllocator;
+
+TEST(InstanceIdAllocator, AllocatesRoundRobin)
+{
+    boost::asio::io_context ioc;
+    InstanceIdAllocator allocator(ioc);
+    std::vector<uint8_t> ids;
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        ids.push_back(allocator.allocate(yield));
+        allocator.release(ids.back(), true);
+        // Just released ID is reused last
+        ids.push_back(allocator.allocate(yield));
+    });
+    ioc.run();
+    EXPECT_EQ(ids, (std::vector<uint8_t>{0, 1}));
+}
+
+TEST(InstanceIdAllocator, AllIdsUnique)
+{
+    boost::asio::io_context ioc;
+    InstanceIdAllocator allocator(ioc);
+    std::set<uint8_t> ids;
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        for (size_t i = 0; i < PLDM_INSTANCE_MAX; i++)
+        {
+            ids.insert(allocator.allocate(yield));
+        }
+    });
+    ioc.run();
+    EXPECT_EQ(ids.size(), static_cast<size_t>(PLDM_INSTANCE_MAX));
+    EXPECT_EQ(*ids.rbegin(), PLDM_INSTANCE_ID_MASK);
+}
+
+TEST(InstanceIdAllocator, WaiterWokenOnRelease)
+{
+    boost::asio::io_context ioc;
+    InstanceIdAllocator allocator(ioc);
+    bool exhausted = false;
+    int waiterId = -1;
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        for (size_t i = 0; i < PLDM_INSTANCE_MAX; i++)
+        {
+            allocator.hold(allocator.allocate(yield));
+        }
+        exhausted = true;
+    });
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        waiterId = allocator.allocate(yield);
+    });
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        boost::asio::post(ioc, yield);
+        ASSERT_TRUE(exhausted);
+        EXPECT_EQ(waiterId, -1);
+        allocator.release(7, true);
+    });
+    ioc.run();
+    EXPECT_EQ(waiterId, 7);
+}
+
+TEST(InstanceIdAllocator, UnansweredIdNotReusedBeforeExpiry)
+{
+    boost::asio::io_context ioc;
+    InstanceIdAllocator allocator(ioc);
+    int id = -1;
+    boost::asio::spawn(ioc, [&](boost::asio::yield_context yield) {
+        for (size_t i = 0; i < PLDM_INSTANCE_MAX; i++)
+        {
+            allocator.hold(allocator.allocate(yield));
+        }
+        allocator.release(3, false);
+        allocator.release(30, true);
+        id = allocator.allocate(yield);
+    });
+    ioc.run();
+    EXPECT_EQ(id, 30);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
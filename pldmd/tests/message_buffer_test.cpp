@@ -0,0 +1,95 @@
+#include <stdexcept>
+#include <vector>
+
+#include "message_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+using pldm::MessageBuffer;
+
+TEST(MessageBuffer, SizeExcludesHeadroom)
+{
+    MessageBuffer buffer(sizeof(pldm_msg_hdr) + 2);
+    EXPECT_EQ(buffer.size(), sizeof(pldm_msg_hdr) + 2);
+    EXPECT_FALSE(buffer.empty());
+    EXPECT_EQ(buffer.msg()->payload, buffer.data() + sizeof(pldm_msg_hdr));
+
+    buffer.resize(0);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(MessageBuffer, PushAndPopFront)
+{
+    const std::vector<uint8_t> message{0x01, 0x02, 0x03};
+    MessageBuffer buffer;
+    buffer.assign(message.data(), message.size());
+    const uint8_t* start = buffer.data();
+
+    buffer.pushFront(0xAA);
+    buffer.pushFront(0x01);
+    EXPECT_EQ(buffer.data(), start - 2);
+    EXPECT_EQ(std::vector<uint8_t>(buffer.begin(), buffer.end()),
+              (std::vector<uint8_t>{0x01, 0xAA, 0x01, 0x02, 0x03}));
+
+    buffer.popFront(2);
+    EXPECT_EQ(buffer.data(), start);
+    EXPECT_EQ(std::vector<uint8_t>(buffer.begin(), buffer.end()), message);
+
+    buffer.popFront(10);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(MessageBuffer, HeadroomExhausted)
+{
+    MessageBuffer buffer(1);
+    for (size_t i = 0; i < MessageBuffer::headroom; i++)
+    {
+        buffer.pushFront(0);
+    }
+    EXPECT_THROW(buffer.pushFront(0), std::length_error);
+    EXPECT_EQ(buffer.size(), MessageBuffer::headroom + 1);
+}
+
+TEST(MessageBuffer, AssignResetsHeadroom)
+{
+    const std::vector<uint8_t> message{0x05, 0x06};
+    MessageBuffer buffer(4);
+    buffer.pushFront(0x01);
+    buffer.assign(message.data(), message.size());
+    EXPECT_EQ(std::vector<uint8_t>(buffer.begin(), buffer.end()), message);
+    EXPECT_NO_THROW(buffer.pushFront(0x01));
+}
+
+TEST(MessageBuffer, MoveTransfersContent)
+{
+    const std::vector<uint8_t> message{0x07, 0x08, 0x09};
+    MessageBuffer source;
+    source.assign(message.data(), message.size());
+    source.popFront();
+
+    MessageBuffer moved(std::move(source));
+    EXPECT_EQ(std::vector<uint8_t>(moved.begin(), moved.end()),
+              (std::vector<uint8_t>{0x08, 0x09}));
+
+    MessageBuffer assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(std::vector<uint8_t>(assigned.begin(), assigned.end()),
+              (std::vector<uint8_t>{0x08, 0x09}));
+}
+
+TEST(MessageBuffer, PooledStorageIsCleared)
+{
+    {
+        MessageBuffer used(16);
+        std::fill(used.data(), used.data() + used.size(), 0xFF);
+    }
+    MessageBuffer buffer(4);
+    EXPECT_EQ(std::vector<uint8_t>(buffer.begin(), buffer.end()),
+              std::vector<uint8_t>(4, 0));
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+#include "rtt_estimator.hpp"
+
+#include <gtest/gtest.h>
+
+using pldm::rtt::RttEstimator;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+TEST(RttEstimator, InitialTimeoutIsClamped)
+{
+    RttEstimator low;
+    EXPECT_EQ(low.getTimeout(milliseconds(1)), pldm::rtt::minTimeout);
+
+    RttEstimator high;
+    EXPECT_EQ(high.getTimeout(milliseconds(10000)), pldm::rtt::maxTimeout);
+
+    // First caller sets the initial timeout
+    RttEstimator estimator;
+    EXPECT_EQ(estimator.getTimeout(milliseconds(100)), milliseconds(100));
+    EXPECT_EQ(estimator.getTimeout(milliseconds(500)), milliseconds(100));
+}
+
+TEST(RttEstimator, FirstSample)
+{
+    RttEstimator estimator;
+    estimator.addSample(milliseconds(40));
+    EXPECT_EQ(estimator.getSrtt(), milliseconds(40));
+    EXPECT_EQ(estimator.getRttvar(), milliseconds(20));
+    // SRTT + 4 * RTTVAR
+    EXPECT_EQ(estimator.getTimeout(milliseconds(500)), milliseconds(120));
+    EXPECT_EQ(estimator.getSamples(), 1u);
+}
+
+TEST(RttEstimator, SmoothedSamples)
+{
+    RttEstimator estimator;
+    estimator.addSample(milliseconds(40));
+    estimator.addSample(milliseconds(80));
+    // SRTT = (7 * 40 + 80) / 8, RTTVAR = (3 * 20 + 40) / 4
+    EXPECT_EQ(estimator.getSrtt(), milliseconds(45));
+    EXPECT_EQ(estimator.getRttvar(), milliseconds(25));
+    EXPECT_EQ(estimator.getRto(), milliseconds(145));
+}
+
+TEST(RttEstimator, StableRttUsesClockGranularity)
+{
+    RttEstimator estimator;
+    for (int i = 0; i < 50; i++)
+    {
+        estimator.addSample(milliseconds(30));
+    }
+    EXPECT_EQ(estimator.getRttvar(), microseconds(0));
+    EXPECT_EQ(estimator.getRto(), milliseconds(31));
+}
+
+TEST(RttEstimator, TimeoutBacksOff)
+{
+    RttEstimator estimator;
+    estimator.getTimeout(milliseconds(100));
+    estimator.onTimeout();
+    EXPECT_EQ(estimator.getRto(), milliseconds(200));
+    for (int i = 0; i < 10; i++)
+    {
+        estimator.onTimeout();
+    }
+    EXPECT_EQ(estimator.getRto(), pldm::rtt::maxTimeout);
+    EXPECT_EQ(estimator.getTimeouts(), 11u);
+
+    // Next sample recovers the timeout
+    estimator.addSample(milliseconds(10));
+    EXPECT_EQ(estimator.getRto(), milliseconds(30));
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
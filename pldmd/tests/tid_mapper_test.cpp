@@ -0,0 +1,78 @@
+#include "tid_mapper.hpp"
+
+#include <gtest/gtest.h>
+
+using pldm::TidMapper;
+using pldm::transport::Endpoint;
+
+TEST(TidMapper, EmptyMapper)
+{
+    TidMapper mapper;
+    EXPECT_FALSE(mapper.getTid(Endpoint{0, 8}));
+    EXPECT_FALSE(mapper.getTid(Endpoint{3, 8}));
+    EXPECT_FALSE(mapper.getEndpoint(1));
+    EXPECT_TRUE(mapper.isFree(1));
+}
+
+TEST(TidMapper, SameEidOnDifferentNetworks)
+{
+    TidMapper mapper;
+    mapper.add(1, Endpoint{0, 8});
+    mapper.add(2, Endpoint{1, 8});
+
+    EXPECT_EQ(mapper.getTid(Endpoint{0, 8}), 1);
+    EXPECT_EQ(mapper.getTid(Endpoint{1, 8}), 2);
+    auto endpoint = mapper.getEndpoint(2);
+    ASSERT_TRUE(endpoint);
+    EXPECT_EQ(endpoint->network, 1);
+    EXPECT_EQ(endpoint->eid, 8);
+    EXPECT_FALSE(mapper.isFree(1));
+}
+
+TEST(TidMapper, RemappingDropsOldEntries)
+{
+    TidMapper mapper;
+    mapper.add(1, Endpoint{0, 8});
+
+    // TID moved to another endpoint
+    mapper.add(1, Endpoint{0, 9});
+    EXPECT_FALSE(mapper.getTid(Endpoint{0, 8}));
+    EXPECT_EQ(mapper.getTid(Endpoint{0, 9}), 1);
+
+    // Endpoint taken over by another TID
+    mapper.add(2, Endpoint{0, 9});
+    EXPECT_TRUE(mapper.isFree(1));
+    EXPECT_EQ(mapper.getTid(Endpoint{0, 9}), 2);
+}
+
+TEST(TidMapper, Remove)
+{
+    TidMapper mapper;
+    mapper.add(5, Endpoint{2, 10});
+    mapper.remove(5);
+    EXPECT_TRUE(mapper.isFree(5));
+    EXPECT_FALSE(mapper.getTid(Endpoint{2, 10}));
+}
+
+TEST(TidMapper, GenerationChangesOnModification)
+{
+    TidMapper mapper;
+    auto generation = mapper.getGeneration();
+
+    mapper.add(1, Endpoint{0, 8});
+    EXPECT_NE(mapper.getGeneration(), generation);
+    generation = mapper.getGeneration();
+
+    // Removing unmapped TID is not a change
+    mapper.remove(2);
+    EXPECT_EQ(mapper.getGeneration(), generation);
+
+    mapper.remove(1);
+    EXPECT_NE(mapper.getGeneration(), generation);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}